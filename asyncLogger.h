@@ -0,0 +1,405 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// ============ 异步二进制日志 =============
+// 热路径上的线程不做格式化、不做 I/O：
+//   - 每条日志是一条定长二进制记录（时间戳、级别、格式串指针、编码后的参数），
+//     写入本线程独占的无锁环形缓冲区（单生产者/单消费者）；
+//   - 后台线程批量取出所有线程的记录，按时间排序后格式化，
+//     一次 fwrite 到 stdout（DEBUG/INFO）或 stderr（WARN/ERROR）；
+//   - 缓冲区满时丢弃并计数，生产者永不阻塞；
+//   - 低于 ASYNC_LOG_LEVEL 的日志在编译期整体消除（参数也不求值）。
+//
+// 用法：LOG_INFO("[{}] [RECV] {}", key, line);
+// 格式串必须是字面量，{} 依次替换为参数；支持整数、浮点、bool、char、
+// 枚举、C 字符串、std::string、std::string_view、char 数组（按 strnlen 截断）。
+// 字符串参数过长时截断，整条记录的参数区为 Record::kPayload 字节。
+
+#define ASYNC_LOG_LEVEL_DEBUG 0
+#define ASYNC_LOG_LEVEL_INFO 1
+#define ASYNC_LOG_LEVEL_WARN 2
+#define ASYNC_LOG_LEVEL_ERROR 3
+
+#ifndef ASYNC_LOG_LEVEL
+#define ASYNC_LOG_LEVEL ASYNC_LOG_LEVEL_INFO
+#endif
+
+#define ASYNC_LOG_AT(lvl, fmt, ...)                                            \
+  do {                                                                         \
+    if constexpr ((lvl) >= ASYNC_LOG_LEVEL)                                    \
+      ::asynclog::write(static_cast<::asynclog::Level>(lvl), "" fmt "",       \
+                        ##__VA_ARGS__);                                        \
+  } while (0)
+
+#define LOG_DEBUG(fmt, ...) ASYNC_LOG_AT(ASYNC_LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...) ASYNC_LOG_AT(ASYNC_LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...) ASYNC_LOG_AT(ASYNC_LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) ASYNC_LOG_AT(ASYNC_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+namespace asynclog {
+
+// 取值与 ASYNC_LOG_LEVEL_* 相同；带前缀的限定名不会与 DEBUG / ERROR 一类的宏冲突
+enum class Level : uint8_t { kDebug = 0, kInfo = 1, kWarn = 2, kError = 3 };
+
+// 定长 256 字节的日志记录
+struct Record {
+  static constexpr std::size_t kSize = 256;
+  static constexpr std::size_t kPayload = kSize - 20;
+
+  uint64_t ts_ns;   // system_clock 纳秒
+  const char *fmt;  // 字面量，生命周期为整个进程
+  uint8_t level;
+  uint8_t nargs;
+  uint16_t used;    // payload 已用字节
+  char payload[kPayload];
+};
+static_assert(sizeof(Record) == Record::kSize, "Record must stay fixed-size");
+
+// 参数编码：1 字节类型标记 + 定长值；字符串为 2 字节长度 + 内容
+class Encoder {
+public:
+  explicit Encoder(Record &r) : r_(r) {}
+
+  template <typename T> void add(const T &v) {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+      put_fixed('b', static_cast<uint64_t>(v));
+    } else if constexpr (std::is_same_v<U, char>) {
+      put_fixed('c', static_cast<uint64_t>(static_cast<unsigned char>(v)));
+    } else if constexpr (std::is_enum_v<U>) {
+      put_fixed('i', static_cast<int64_t>(v));
+    } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+      put_fixed('i', static_cast<int64_t>(v));
+    } else if constexpr (std::is_integral_v<U>) {
+      put_fixed('u', static_cast<uint64_t>(v));
+    } else if constexpr (std::is_floating_point_v<U>) {
+      put_fixed('d', static_cast<double>(v));
+    } else if constexpr (std::is_array_v<T>) {
+      put_str(std::string_view(v, strnlen(v, std::extent_v<T>)));
+    } else if constexpr (std::is_same_v<U, const char *> ||
+                         std::is_same_v<U, char *>) {
+      put_str(v ? std::string_view(v) : std::string_view("(null)"));
+    } else {
+      put_str(std::string_view(v));
+    }
+  }
+
+private:
+  template <typename V> void put_fixed(char tag, V v) {
+    if (std::size_t(r_.used) + 1 + sizeof(V) > Record::kPayload)
+      return;
+    r_.payload[r_.used] = tag;
+    std::memcpy(r_.payload + r_.used + 1, &v, sizeof(V));
+    r_.used += 1 + sizeof(V);
+    ++r_.nargs;
+  }
+
+  void put_str(std::string_view s) {
+    if (std::size_t(r_.used) + 3 > Record::kPayload)
+      return;
+    std::size_t room = Record::kPayload - r_.used - 3;
+    uint16_t len = static_cast<uint16_t>(std::min(s.size(), room));
+    r_.payload[r_.used] = 's';
+    std::memcpy(r_.payload + r_.used + 1, &len, 2);
+    std::memcpy(r_.payload + r_.used + 3, s.data(), len);
+    r_.used += 3 + len;
+    ++r_.nargs;
+  }
+
+  Record &r_;
+};
+
+// 每线程一个的单生产者/单消费者环形缓冲区
+class ThreadBuffer {
+public:
+  static constexpr std::size_t kCapacity = 4096;  // 2 的幂
+
+  ThreadBuffer() : ring_(new Record[kCapacity]) {}
+
+  Record *try_claim() {
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) >= kCapacity) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return &ring_[tail & (kCapacity - 1)];
+  }
+
+  // 返回发布后缓冲区中的记录数
+  std::size_t publish() {
+    std::size_t tail = tail_.load(std::memory_order_relaxed) + 1;
+    tail_.store(tail, std::memory_order_release);
+    return tail - head_.load(std::memory_order_relaxed);
+  }
+
+  template <typename F> std::size_t consume(F &&f) {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    std::size_t tail = tail_.load(std::memory_order_acquire);
+    for (std::size_t i = head; i != tail; ++i)
+      f(ring_[i & (kCapacity - 1)]);
+    head_.store(tail, std::memory_order_release);
+    return tail - head;
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  std::atomic<uint64_t> dropped{0};
+  std::atomic<bool> retired{false};  // 所属线程已退出
+
+private:
+  std::unique_ptr<Record[]> ring_;
+  alignas(64) std::atomic<std::size_t> head_{0};  // 后台线程读位置
+  alignas(64) std::atomic<std::size_t> tail_{0};  // 生产线程写位置
+};
+
+class Logger {
+public:
+  static Logger &instance() {
+    static Logger logger;
+    return logger;
+  }
+
+  std::shared_ptr<ThreadBuffer> register_thread() {
+    auto buf = std::make_shared<ThreadBuffer>();
+    std::lock_guard<std::mutex> lock(mtx_);
+    buffers_.push_back(buf);
+    return buf;
+  }
+
+  // 阻塞直到调用前已写入的记录全部输出
+  void flush() {
+    std::unique_lock<std::mutex> lock(cycle_mtx_);
+    uint64_t target = cycles_ + 2;
+    wake();
+    cycle_cv_.wait(lock, [&] { return cycles_ >= target || stop_; });
+  }
+
+  // 唤醒后台线程立即取一轮。不加锁，生产者可调用；
+  // 与后台线程进入等待恰好交错时唤醒会丢失，最迟延后 kFlushInterval
+  void wake() {
+    wake_.store(true, std::memory_order_relaxed);
+    wake_cv_.notify_one();
+  }
+
+  ~Logger() {
+    stop_ = true;
+    wake();
+    if (worker_.joinable())
+      worker_.join();
+    drain();
+  }
+
+private:
+  // 空闲时后台线程最长等待这么久再取一轮，即无人唤醒时日志的最大输出延迟
+  static constexpr std::chrono::milliseconds kFlushInterval{10};
+
+  Logger() : worker_([this] { run(); }) {}
+
+  // 取到记录就接着取；取空后在条件变量上等待，由 flush()、缓冲区半满或超时唤醒
+  void run() {
+    while (!stop_.load(std::memory_order_relaxed)) {
+      if (drain() == 0) {
+        std::unique_lock<std::mutex> lock(wake_mtx_);
+        wake_cv_.wait_for(lock, kFlushInterval, [this] {
+          return wake_.load(std::memory_order_relaxed) ||
+                 stop_.load(std::memory_order_relaxed);
+        });
+        wake_.store(false, std::memory_order_relaxed);
+      }
+      {
+        std::lock_guard<std::mutex> lock(cycle_mtx_);
+        ++cycles_;
+      }
+      cycle_cv_.notify_all();
+    }
+  }
+
+  std::size_t drain() {
+    std::vector<std::shared_ptr<ThreadBuffer>> bufs;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      bufs = buffers_;
+    }
+    batch_.clear();
+    uint64_t dropped = 0;
+    for (auto &b : bufs) {
+      b->consume([this](const Record &r) { batch_.push_back(r); });
+      dropped += b->dropped.exchange(0, std::memory_order_relaxed);
+    }
+    {
+      // 线程退出且已取空的缓冲区可以回收
+      std::lock_guard<std::mutex> lock(mtx_);
+      buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                    [](const std::shared_ptr<ThreadBuffer> &b) {
+                                      return b->retired.load() && b->empty();
+                                    }),
+                     buffers_.end());
+    }
+    if (batch_.empty() && dropped == 0)
+      return 0;
+
+    std::stable_sort(batch_.begin(), batch_.end(),
+                     [](const Record &a, const Record &b) {
+                       return a.ts_ns < b.ts_ns;
+                     });
+    out_.clear();
+    err_.clear();
+    for (const Record &r : batch_)
+      format(r, r.level >= static_cast<uint8_t>(Level::kWarn) ? err_ : out_);
+    if (dropped)
+      err_ += "[WARN] asynclog: dropped " + std::to_string(dropped) +
+              " records (buffer full)\n";
+    if (!out_.empty()) {
+      std::fwrite(out_.data(), 1, out_.size(), stdout);
+      std::fflush(stdout);
+    }
+    if (!err_.empty()) {
+      std::fwrite(err_.data(), 1, err_.size(), stderr);
+      std::fflush(stderr);
+    }
+    return batch_.size();
+  }
+
+  static void format(const Record &r, std::string &out) {
+    static const char *const kTags[] = {"[DBG ]", "[INFO]", "[WARN]", "[ERR ]"};
+    char head[48];
+    std::time_t sec = static_cast<std::time_t>(r.ts_ns / 1000000000ull);
+    std::tm tm;
+    localtime_r(&sec, &tm);
+    int n = std::snprintf(head, sizeof(head), "%02d:%02d:%02d.%06u %s ",
+                          tm.tm_hour, tm.tm_min, tm.tm_sec,
+                          static_cast<unsigned>(r.ts_ns % 1000000000ull / 1000),
+                          kTags[r.level & 3]);
+    out.append(head, n);
+
+    const char *p = r.payload;
+    const char *end = r.payload + r.used;
+    for (const char *f = r.fmt; *f; ++f) {
+      if (f[0] == '{' && f[1] == '}') {
+        p = append_arg(p, end, out);
+        ++f;
+      } else {
+        out.push_back(*f);
+      }
+    }
+    out.push_back('\n');
+  }
+
+  static const char *append_arg(const char *p, const char *end,
+                                std::string &out) {
+    if (p >= end)
+      return p;
+    char buf[32];
+    char tag = *p++;
+    switch (tag) {
+    case 'i': {
+      int64_t v;
+      std::memcpy(&v, p, 8);
+      out.append(buf, std::snprintf(buf, sizeof(buf), "%lld",
+                                    static_cast<long long>(v)));
+      return p + 8;
+    }
+    case 'u':
+    case 'b':
+    case 'c': {
+      uint64_t v;
+      std::memcpy(&v, p, 8);
+      if (tag == 'b')
+        out += v ? "true" : "false";
+      else if (tag == 'c')
+        out.push_back(static_cast<char>(v));
+      else
+        out.append(buf, std::snprintf(buf, sizeof(buf), "%llu",
+                                      static_cast<unsigned long long>(v)));
+      return p + 8;
+    }
+    case 'd': {
+      double v;
+      std::memcpy(&v, p, 8);
+      out.append(buf, std::snprintf(buf, sizeof(buf), "%g", v));
+      return p + 8;
+    }
+    case 's': {
+      uint16_t len;
+      std::memcpy(&len, p, 2);
+      out.append(p + 2, len);
+      return p + 2 + len;
+    }
+    default:
+      return end;
+    }
+  }
+
+  std::mutex mtx_;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+  std::vector<Record> batch_;  // 以下仅后台线程使用
+  std::string out_;
+  std::string err_;
+  std::mutex cycle_mtx_;
+  std::condition_variable cycle_cv_;
+  uint64_t cycles_ = 0;
+  std::mutex wake_mtx_;
+  std::condition_variable wake_cv_;
+  std::atomic<bool> wake_{false};
+  std::atomic<bool> stop_{false};
+  std::thread worker_;
+};
+
+// 线程退出时把缓冲区标记为可回收，剩余记录仍会被后台线程输出
+struct ThreadHandle {
+  std::shared_ptr<ThreadBuffer> buf;
+  ~ThreadHandle() {
+    if (buf)
+      buf->retired = true;
+  }
+};
+
+inline ThreadBuffer &local_buffer() {
+  thread_local ThreadHandle handle;
+  if (!handle.buf)
+    handle.buf = Logger::instance().register_thread();
+  return *handle.buf;
+}
+
+template <typename... Args>
+inline void write(Level level, const char *fmt, const Args &...args) {
+  ThreadBuffer &buf = local_buffer();
+  Record *r = buf.try_claim();
+  if (!r)
+    return;
+  r->ts_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+  r->fmt = fmt;
+  r->level = static_cast<uint8_t>(level);
+  r->nargs = 0;
+  r->used = 0;
+  Encoder enc(*r);
+  (enc.add(args), ...);
+  // 写到半满时不等超时，提前唤醒后台线程，减少突发下的丢弃
+  if (buf.publish() == ThreadBuffer::kCapacity / 2)
+    Logger::instance().wake();
+}
+
+inline void flush() { Logger::instance().flush(); }
+
+} // namespace asynclog
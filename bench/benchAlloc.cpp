@@ -0,0 +1,201 @@
+// 收发路径堆分配计数：稳态下每条消息触发多少次 operator new
+//
+// 编译: g++ -std=c++20 -O2 -I.. -DASYNC_LOG_LEVEL=ASYNC_LOG_LEVEL_WARN benchAlloc.cpp -o benchAlloc -lpthread
+// 运行: ./benchAlloc [消息数=200000]
+// 以 C++20 编译时同一负载再用协程引擎跑一遍；C++17 只有回调引擎
+//
+// 进程内起一个逐行应答的回显服务端（单独线程，不计数），客户端一条连接，
+// 预热后只统计客户端 IO 线程与生产者线程的分配次数。消息体预先构造并共享，
+// 因此结果只反映传输路径本身（post / async_write / async_read / 队列）。
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#include "clientManager.h"
+
+static thread_local bool t_counting = false;
+static std::atomic<uint64_t> g_allocs{0};
+
+// 全部形式的 operator new / delete 都经下面两个函数，成对替换，
+// 标准库与 asio 内部用到数组、nothrow 或对齐版本时同样计数
+static void *count_alloc(std::size_t n, std::size_t align = 0) noexcept {
+  if (t_counting)
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (n == 0)
+    n = 1;
+  if (align <= alignof(std::max_align_t))
+    return std::malloc(n);
+  return std::aligned_alloc(align, (n + align - 1) / align * align);
+}
+
+static void *count_alloc_or_throw(std::size_t n, std::size_t align = 0) {
+  if (void *p = count_alloc(n, align))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t n) { return count_alloc_or_throw(n); }
+void *operator new[](std::size_t n) { return count_alloc_or_throw(n); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept { return count_alloc(n); }
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept { return count_alloc(n); }
+void *operator new(std::size_t n, std::align_val_t a) {
+  return count_alloc_or_throw(n, static_cast<std::size_t>(a));
+}
+void *operator new[](std::size_t n, std::align_val_t a) {
+  return count_alloc_or_throw(n, static_cast<std::size_t>(a));
+}
+void *operator new(std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept {
+  return count_alloc(n, static_cast<std::size_t>(a));
+}
+void *operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept {
+  return count_alloc(n, static_cast<std::size_t>(a));
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+
+using boost::asio::ip::tcp;
+
+// 每收到一行回一行 "ok\n"
+class EchoSession : public std::enable_shared_from_this<EchoSession> {
+public:
+  explicit EchoSession(tcp::socket s) : socket_(std::move(s)) {}
+  void start() { read(); }
+
+private:
+  void read() {
+    auto self = shared_from_this();
+    socket_.async_read_some(
+        boost::asio::buffer(buf_), [this, self](boost::system::error_code ec,
+                                                std::size_t n) {
+          if (ec)
+            return;
+          std::size_t lines = 0;
+          for (std::size_t i = 0; i < n; ++i)
+            lines += buf_[i] == '\n';
+          reply_.assign(lines * 3, ' ');
+          for (std::size_t i = 0; i < lines; ++i)
+            reply_.replace(i * 3, 3, "ok\n");
+          boost::asio::async_write(socket_, boost::asio::buffer(reply_),
+                                   [this, self](boost::system::error_code ec,
+                                                std::size_t) {
+                                     if (!ec)
+                                       read();
+                                   });
+        });
+  }
+
+  tcp::socket socket_;
+  char buf_[64 * 1024];
+  std::string reply_;
+};
+
+static void accept_loop(tcp::acceptor &acc) {
+  acc.async_accept([&acc](boost::system::error_code ec, tcp::socket s) {
+    if (!ec)
+      std::make_shared<EchoSession>(std::move(s))->start();
+    accept_loop(acc);
+  });
+}
+
+template <typename Cond> static bool wait_for(Cond cond, int ms = 10000) {
+  for (int i = 0; i < ms && !cond(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  return cond();
+}
+
+static void run(const char *name, WriteMode mode, ConnEngine engine,
+                uint16_t port, std::size_t n) {
+  boost::asio::io_context io;
+  auto mgr = std::make_shared<ClientManager>(io);
+  ConnInfo info;
+  info.ip = "127.0.0.1";
+  info.port = port;
+  info.write_mode = mode;
+  info.engine = engine;
+  info.high_watermark = 0;
+  ConnHandle h = mgr->add_connection(info);
+  std::thread io_thread([&io] {
+    auto guard = boost::asio::make_work_guard(io);
+    t_counting = true;
+    io.run();
+  });
+
+  WriteStats ws;
+  if (!wait_for([&] { return mgr->write_stats(h, ws); })) {
+    std::printf("%-16s connect failed\n", name);
+    io.stop();
+    io_thread.join();
+    return;
+  }
+  SharedMessage msg = make_shared_message(std::string("payload-0123456789\n"));
+  // 已收到的回复数；取快照本身会分配，查询期间暂停计数
+  auto replies = [&] {
+    bool counting = t_counting;
+    t_counting = false;
+    LatencySummary rtt;
+    mgr->rtt_stats(h, rtt);
+    t_counting = counting;
+    return rtt.count;
+  };
+  auto send = [&](std::size_t count) {
+    uint64_t base = replies();
+    for (std::size_t i = 0; i < count; ++i) {
+      mgr->send_message(h, msg);
+      if (i % 256 == 255)  // 控制在途量，避免测成队列增长
+        wait_for([&] { return replies() + 1024 > base + i; });
+    }
+    wait_for([&] { return replies() >= base + count; });
+  };
+
+  send(n / 10);  // 预热：队列、分帧器、deque 块、回收缓存都到稳态
+  t_counting = true;
+  uint64_t before = g_allocs.load();
+  auto t0 = std::chrono::steady_clock::now();
+  send(n);
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+                   .count();
+  uint64_t allocs = g_allocs.load() - before;
+  t_counting = false;
+  std::printf("%-16s %10zu msgs  %10llu allocs  %6.3f allocs/msg  %8.0f msgs/s\n",
+              name, n, static_cast<unsigned long long>(allocs),
+              static_cast<double>(allocs) / n, n / sec);
+  io.stop();
+  io_thread.join();
+}
+
+int main(int argc, char **argv) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+  boost::asio::io_context server_io;
+  tcp::acceptor acc(server_io, tcp::endpoint(tcp::v4(), 0));
+  uint16_t port = acc.local_endpoint().port();
+  accept_loop(acc);
+  std::thread server([&server_io] { server_io.run(); });
+
+  run("ping-pong", WriteMode::PING_PONG, ConnEngine::CALLBACK, port, n / 4);
+  run("pipelined", WriteMode::PIPELINED, ConnEngine::CALLBACK, port, n);
+#ifdef CLIENT_HAS_COROUTINES
+  run("ping-pong/coro", WriteMode::PING_PONG, ConnEngine::COROUTINE, port, n / 4);
+  run("pipelined/coro", WriteMode::PIPELINED, ConnEngine::COROUTINE, port, n);
+#endif
+
+  server_io.stop();
+  server.join();
+  return 0;
+}
@@ -0,0 +1,223 @@
+// 成员索引（SubscriptionIndex / GroupIndex）的上下线开销：
+// 整表写时复制（最初实现）vs 原地增删 + 读时合并重建（现实现）
+//
+// 编译: g++ -std=c++17 -O2 -I.. -DASYNC_LOG_LEVEL=ASYNC_LOG_LEVEL_WARN benchIndex.cpp -o benchIndex -lpthread
+// 运行: ./benchIndex [连接数=10000,50000] [路由间隔微秒=100]
+//
+// 模拟一次全量建连与一次全量断开（重连风暴的两半）：N 条连接逐个订阅 EVENT_A
+// （或加入同一个端点组），再逐个移除。同时有一个路由线程每隔固定间隔取一次
+// 成员列表并遍历，模拟事件持续到达；输出两半各自的耗时，以及路由线程单次取列表的最大耗时。
+// 连接对象只构造、不建连。
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clientManager.h"
+
+using Clock = std::chrono::steady_clock;
+
+// 原实现：每次增删都复制并替换该类型的整张列表
+class CowIndex {
+public:
+  using List = std::vector<Connection::Ptr>;
+  using ListPtr = std::shared_ptr<const List>;
+
+  void add(EventType type, const Connection::Ptr &conn) {
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    ListPtr &cur = lists_[type];
+    auto next = cur ? std::make_shared<List>(*cur) : std::make_shared<List>();
+    if (std::find(next->begin(), next->end(), conn) != next->end())
+      return;
+    next->push_back(conn);
+    cur = std::move(next);
+  }
+
+  void remove_all(const Connection::Ptr &conn) {
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    for (auto &kv : lists_) {
+      if (!kv.second ||
+          std::find(kv.second->begin(), kv.second->end(), conn) == kv.second->end())
+        continue;
+      auto next = std::make_shared<List>(*kv.second);
+      next->erase(std::remove(next->begin(), next->end(), conn), next->end());
+      kv.second = std::move(next);
+    }
+  }
+
+  ListPtr subscribers(EventType type) const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    auto it = lists_.find(type);
+    return it == lists_.end() ? nullptr : it->second;
+  }
+
+private:
+  mutable std::shared_mutex mtx_;
+  std::map<EventType, ListPtr> lists_;
+};
+
+// 原 GroupIndex 的成员维护：每次增删复制该组列表，移除时逐组查找
+class CowGroupIndex {
+public:
+  using List = std::vector<Connection::Ptr>;
+  using ListPtr = std::shared_ptr<const List>;
+
+  void add(const std::string &name, const Connection::Ptr &conn) {
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    ListPtr &cur = groups_[name];
+    auto next = cur ? std::make_shared<List>(*cur) : std::make_shared<List>();
+    if (std::find(next->begin(), next->end(), conn) == next->end()) {
+      next->push_back(conn);
+      cur = std::move(next);
+    }
+  }
+
+  void remove_all(const Connection::Ptr &conn) {
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    for (auto &kv : groups_) {
+      if (!kv.second ||
+          std::find(kv.second->begin(), kv.second->end(), conn) == kv.second->end())
+        continue;
+      auto next = std::make_shared<List>(*kv.second);
+      next->erase(std::remove(next->begin(), next->end(), conn), next->end());
+      kv.second = std::move(next);
+    }
+  }
+
+  ListPtr view(const std::string &name) const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    auto it = groups_.find(name);
+    return it == groups_.end() ? nullptr : it->second;
+  }
+
+private:
+  mutable std::shared_mutex mtx_;
+  std::map<std::string, ListPtr> groups_;
+};
+
+// 统一成 join / leave / read 三个操作
+struct CowSubs {
+  CowIndex index;
+  void join(const Connection::Ptr &c) { index.add(EventType::EVENT_A, c); }
+  void leave(const Connection::Ptr &c) { index.remove_all(c); }
+  CowIndex::ListPtr read() const { return index.subscribers(EventType::EVENT_A); }
+};
+
+struct Subs {
+  SubscriptionIndex index;
+  void join(const Connection::Ptr &c) { index.add(EventType::EVENT_A, c); }
+  void leave(const Connection::Ptr &c) { index.remove_all(c); }
+  SubscriptionIndex::ListPtr read() const { return index.subscribers(EventType::EVENT_A); }
+};
+
+struct CowGroup {
+  CowGroupIndex index;
+  void join(const Connection::Ptr &c) { index.add("g", c); }
+  void leave(const Connection::Ptr &c) { index.remove_all(c); }
+  CowGroupIndex::ListPtr read() const { return index.view("g"); }
+};
+
+struct Group {
+  GroupIndex index;
+  void join(const Connection::Ptr &c) { index.add("g", GroupRouting::QUEUE_DEPTH, c); }
+  void leave(const Connection::Ptr &c) { index.remove(c); }
+  GroupIndex::ListPtr read() const {
+    GroupIndex::View v;
+    index.view(index.find("g"), v);
+    return v.members;
+  }
+};
+
+struct Result {
+  double connect_s = 0;
+  double disconnect_s = 0;
+  double max_read_us = 0;  // 路由线程单次取列表的最大耗时
+  uint64_t reads = 0;
+};
+
+template <typename Index>
+static Result run(const std::vector<Connection::Ptr> &conns, int route_gap_us) {
+  Index index;
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> reads{0};
+  std::atomic<int64_t> max_read_ns{0};
+  std::thread router([&] {
+    std::size_t touched = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+      auto t0 = Clock::now();
+      auto subs = index.read();
+      int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0)
+                       .count();
+      if (ns > max_read_ns.load(std::memory_order_relaxed))
+        max_read_ns.store(ns, std::memory_order_relaxed);
+      if (subs)
+        for (const auto &c : *subs)
+          touched += c.use_count() > 0;
+      reads.fetch_add(1, std::memory_order_relaxed);
+      std::this_thread::sleep_for(std::chrono::microseconds(route_gap_us));
+    }
+    if (touched == 1)
+      std::printf(" ");  // 防止遍历被优化掉
+  });
+
+  Result r;
+  auto t0 = Clock::now();
+  for (const auto &c : conns)
+    index.join(c);
+  auto t1 = Clock::now();
+  for (const auto &c : conns)
+    index.leave(c);
+  auto t2 = Clock::now();
+  stop = true;
+  router.join();
+  r.connect_s = std::chrono::duration<double>(t1 - t0).count();
+  r.disconnect_s = std::chrono::duration<double>(t2 - t1).count();
+  r.max_read_us = max_read_ns.load() / 1e3;
+  r.reads = reads.load();
+  return r;
+}
+
+static void print(std::size_t n, const char *name, const Result &r) {
+  std::printf("%8zu %-10s %10.3f s %12.3f s %11.1f us %10llu\n", n, name, r.connect_s,
+              r.disconnect_s, r.max_read_us, static_cast<unsigned long long>(r.reads));
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::size_t> sizes;
+  if (argc > 1) {
+    for (char *p = argv[1]; *p;) {
+      sizes.push_back(std::strtoul(p, &p, 10));
+      if (*p == ',')
+        ++p;
+    }
+  } else {
+    sizes = {10000, 50000};
+  }
+  int route_gap_us = argc > 2 ? std::atoi(argv[2]) : 100;
+
+  boost::asio::io_context io;
+  auto wheel = TimingWheel::create(io);
+  ConnInfo info;
+  info.read_buffer_size = 64;
+
+  std::printf("%8s %-10s %12s %14s %14s %10s\n", "conns", "index", "connect-all",
+              "disconnect-all", "max read", "reads");
+  for (std::size_t n : sizes) {
+    std::vector<Connection::Ptr> conns;
+    conns.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+      conns.push_back(Connection::create(io, "c" + std::to_string(i), info, wheel));
+    print(n, "subs copy", run<CowSubs>(conns, route_gap_us));
+    print(n, "subs", run<Subs>(conns, route_gap_us));
+    print(n, "group copy", run<CowGroup>(conns, route_gap_us));
+    print(n, "group", run<Group>(conns, route_gap_us));
+  }
+  return 0;
+}
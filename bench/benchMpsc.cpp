@@ -0,0 +1,119 @@
+// 事件队列微基准：原 mutex + deque + 拷贝拉取 vs 无锁 MpscQueue 整批摘取
+//
+// 编译: g++ -std=c++17 -O2 -I.. benchMpsc.cpp -o benchMpsc -lpthread
+// 运行: ./benchMpsc [每个生产者事件数=1000000]
+//
+// P 个生产者线程（模拟 Redis 订阅线程）持续入队共享事件体，
+// 1 个消费者线程（模拟 IO 线程 strand）不停地整批取出。
+// 输出总吞吐以及生产者单次入队的平均/最大耗时。
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mpscQueue.h"
+
+using Clock = std::chrono::steady_clock;
+using Payload = std::shared_ptr<const std::vector<uint8_t>>;
+
+struct EventMsg {
+  Payload data;
+};
+
+// Connection 原实现：enqueue_event / fetch_and_clear_events
+class MutexQueue {
+public:
+  void push(EventMsg msg) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    q_.push_back(std::move(msg));
+  }
+  template <typename F> std::size_t drain(F &&f) {
+    std::vector<EventMsg> batch;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      batch.assign(q_.begin(), q_.end());
+      q_.clear();
+    }
+    for (auto &ev : batch)
+      f(std::move(ev));
+    return batch.size();
+  }
+
+private:
+  std::deque<EventMsg> q_;
+  std::mutex mtx_;
+};
+
+struct Result {
+  double mops;
+  double avg_push_ns;
+  double max_push_us;
+};
+
+template <typename Queue>
+static Result run(int producers, std::size_t per_producer) {
+  Queue q;
+  Payload payload = std::make_shared<const std::vector<uint8_t>>(64, 'x');
+  std::atomic<bool> done{false};
+  std::atomic<uint64_t> push_ns{0};
+  std::atomic<uint64_t> max_ns{0};
+  uint64_t consumed = 0;
+  const uint64_t total = static_cast<uint64_t>(producers) * per_producer;
+
+  auto t0 = Clock::now();
+  std::thread consumer([&] {
+    while (consumed < total) {
+      std::size_t n = q.drain([](EventMsg &&ev) { (void)ev; });
+      consumed += n;
+      if (n == 0)
+        std::this_thread::yield();
+    }
+    done = true;
+  });
+  std::vector<std::thread> ps;
+  for (int p = 0; p < producers; ++p) {
+    ps.emplace_back([&] {
+      uint64_t sum = 0, worst = 0;
+      for (std::size_t i = 0; i < per_producer; ++i) {
+        auto a = Clock::now();
+        q.push(EventMsg{payload});
+        uint64_t d = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         Clock::now() - a)
+                         .count();
+        sum += d;
+        worst = std::max(worst, d);
+      }
+      push_ns.fetch_add(sum);
+      uint64_t cur = max_ns.load();
+      while (worst > cur && !max_ns.compare_exchange_weak(cur, worst)) {
+      }
+    });
+  }
+  for (auto &t : ps)
+    t.join();
+  consumer.join();
+  double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+  return Result{total / sec / 1e6, static_cast<double>(push_ns.load()) / total,
+                max_ns.load() / 1000.0};
+}
+
+int main(int argc, char **argv) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::printf("%9s | %28s | %28s\n", "", "mutex+deque", "MpscQueue");
+  std::printf("%9s | %8s %9s %9s | %8s %9s %9s\n", "producers", "Mops/s",
+              "avg ns", "max us", "Mops/s", "avg ns", "max us");
+  for (int p : {1, 2, 4, 8}) {
+    Result a = run<MutexQueue>(p, n);
+    Result b = run<MpscQueue<EventMsg>>(p, n);
+    std::printf("%9d | %8.2f %9.1f %9.1f | %8.2f %9.1f %9.1f\n", p, a.mops,
+                a.avg_push_ns, a.max_push_us, b.mops, b.avg_push_ns,
+                b.max_push_us);
+  }
+  return 0;
+}
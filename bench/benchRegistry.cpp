@@ -0,0 +1,162 @@
+// 连接注册表扩展性压测：单锁 std::map（最初实现）vs ShardedRegistry（按 key 分片）
+// vs SlotTable（ClientManager 现实现，按整数句柄下标查找）
+//
+// 编译: g++ -std=c++17 -O2 -I.. benchRegistry.cpp -o benchRegistry -lpthread
+// 运行: ./benchRegistry [连接数=10000] [每轮毫秒=500]
+//
+// 每轮 N 个线程做随机查找 + 模拟发送（拷贝 shared_ptr），
+// 同时有一个线程不断全量遍历（模拟心跳广播），一个线程不断删除/插入（模拟断线重连）。
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "connRegistry.h"
+#include "slotTable.h"
+
+struct FakeConn {
+  std::atomic<uint64_t> sent{0};
+};
+using FakePtr = std::shared_ptr<FakeConn>;
+
+// 原实现：std::map + 一把全局互斥锁
+class LockedMap {
+public:
+  void insert_or_assign(const std::string &key, FakePtr v) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    map_[key] = std::move(v);
+  }
+  bool erase(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return map_.erase(key) > 0;
+  }
+  template <typename F> bool visit(const std::string &key, F &&f) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = map_.find(key);
+    if (it == map_.end())
+      return false;
+    f(it->second);
+    return true;
+  }
+  template <typename F> void for_each(F &&f) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto &kv : map_)
+      f(kv.first, kv.second);
+  }
+
+private:
+  std::map<std::string, FakePtr> map_;
+  std::mutex mtx_;
+};
+
+// 句柄在重连间不变，断线/重连只替换槽位上的值
+class HandleTable {
+public:
+  void insert_or_assign(SlotHandle h, FakePtr v) {
+    table_.exchange(h, std::move(v));
+  }
+  bool erase(SlotHandle h) { return table_.exchange(h, nullptr); }
+  template <typename F> bool visit(SlotHandle h, F &&f) {
+    return table_.visit(h, f);
+  }
+  template <typename F> void for_each(F &&f) { table_.for_each(f); }
+  SlotHandle allocate() { return table_.allocate(); }
+
+private:
+  SlotTable<FakePtr> table_;
+};
+
+static std::vector<std::string> make_keys(std::size_t n) {
+  std::vector<std::string> keys;
+  keys.reserve(n);
+  for (std::size_t i = 0; i < n; ++i)
+    keys.push_back("10.0." + std::to_string(i / 250) + "." +
+                   std::to_string(i % 250) + ":" + std::to_string(8000 + i % 7));
+  return keys;
+}
+
+template <typename Registry, typename Key>
+static double run(Registry &reg, const std::vector<Key> &keys,
+                  int threads, int ms) {
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> ops{0};
+  std::vector<std::thread> workers;
+
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      std::mt19937 rng(t + 1);
+      std::uniform_int_distribution<std::size_t> pick(0, keys.size() - 1);
+      uint64_t local = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        reg.visit(keys[pick(rng)], [](const FakePtr &c) {
+          FakePtr copy = c;  // 模拟 push_message 捕获 self
+          copy->sent.fetch_add(1, std::memory_order_relaxed);
+        });
+        ++local;
+      }
+      ops.fetch_add(local);
+    });
+  }
+  std::thread iterator([&] {
+    while (!stop.load(std::memory_order_relaxed))
+      reg.for_each([](const auto &, const FakePtr &c) {
+        c->sent.fetch_add(1, std::memory_order_relaxed);
+      });
+  });
+  std::thread churn([&] {
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<std::size_t> pick(0, keys.size() - 1);
+    while (!stop.load(std::memory_order_relaxed)) {
+      const Key &k = keys[pick(rng)];
+      reg.erase(k);
+      reg.insert_or_assign(k, std::make_shared<FakeConn>());
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  stop = true;
+  for (auto &w : workers)
+    w.join();
+  iterator.join();
+  churn.join();
+  return ops.load() / (ms / 1000.0) / 1e6;
+}
+
+int main(int argc, char **argv) {
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+  int ms = argc > 2 ? std::atoi(argv[2]) : 500;
+  auto keys = make_keys(n);
+
+  LockedMap locked;
+  ShardedRegistry<FakePtr> sharded;
+  HandleTable slots;
+  std::vector<SlotHandle> handles;
+  for (const auto &k : keys) {
+    locked.insert_or_assign(k, std::make_shared<FakeConn>());
+    sharded.insert_or_assign(k, std::make_shared<FakeConn>());
+    handles.push_back(slots.allocate());
+    slots.insert_or_assign(handles.back(), std::make_shared<FakeConn>());
+  }
+
+  unsigned hw = std::thread::hardware_concurrency();
+  std::printf("connections=%zu  hardware_threads=%u  (lookups+sends, Mops/s)\n",
+              n, hw);
+  std::printf("%8s %14s %14s %14s %8s\n", "threads", "map+mutex", "sharded",
+              "handle", "speedup");
+  for (int t = 1; t <= static_cast<int>(std::max(hw, 2u)) * 2; t *= 2) {
+    double a = run(locked, keys, t, ms);
+    double b = run(sharded, keys, t, ms);
+    double c = run(slots, handles, t, ms);
+    std::printf("%8d %14.2f %14.2f %14.2f %7.1fx\n", t, a, b, c,
+                a > 0 ? c / a : 0.0);
+  }
+  return 0;
+}
@@ -0,0 +1,183 @@
+// RedisSubscriber 吞吐基准：订阅端解析 + on_redis_events 路由
+//
+// 编译: g++ -std=c++17 -O2 -I.. benchResp.cpp -o benchResp -lpthread
+// 运行: ./benchResp [消息数=2000000] [消息体字节=64] [--resp3]
+//       ./benchResp [消息数] [消息体字节] --redis ip:port
+//
+// 默认在进程内起一个 RESP 替身服务：收到 SUBSCRIBE 后回确认，
+// 然后把预先编码好的 message 推送（两个频道交替）成块写出，
+// 订阅端与替身之间只有本机 TCP，测得的是订阅客户端自身的上限。
+// --redis 时改连真实 Redis：另开一条连接流水线发送 PUBLISH，回复只读不解析。
+// ClientManager 不挂设备连接，路由只做订阅查找，不含下发开销。
+// 输出从第一条推送到最后一条的 msgs/s、MB/s 与批次数。
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "redisSubscriber.h"
+
+using boost::asio::ip::tcp;
+
+static std::string encode(const std::vector<std::string> &args, char type = '*') {
+  std::string out(1, type);
+  out += std::to_string(args.size()) + "\r\n";
+  for (const auto &a : args)
+    out += "$" + std::to_string(a.size()) + "\r\n" + a + "\r\n";
+  return out;
+}
+
+// 进程内替身：只服务一个订阅连接
+static void stand_in(tcp::acceptor &acceptor, std::size_t total,
+                     const std::string &payload, bool resp3) {
+  tcp::socket s(acceptor.get_executor());
+  acceptor.accept(s);
+  s.set_option(tcp::no_delay(true));
+  RespReader reader(1 << 16);
+  bool subscribed = false;
+  while (!subscribed) {
+    auto space = reader.prepare();
+    std::size_t n = s.read_some(boost::asio::buffer(space.first, space.second));
+    reader.commit(n, [&](const RespFrame &f) {
+      std::string reply;
+      if (f.item(0) == "HELLO") {
+        reply = "%1\r\n$5\r\nproto\r\n:3\r\n";
+      } else if (f.item(0) == "SUBSCRIBE") {
+        for (std::size_t i = 1; i < f.count; ++i)
+          reply += encode({"subscribe", std::string(f.item(i))}, resp3 ? '>' : '*');
+        subscribed = true;
+      }
+      boost::asio::write(s, boost::asio::buffer(reply));
+    });
+  }
+  const char type = resp3 ? '>' : '*';
+  std::string frames[2] = {encode({"message", "events:A", payload}, type),
+                           encode({"message", "events:B", payload}, type)};
+  // 每块约 256KB，写满后整块发送
+  std::string chunk;
+  std::size_t per_chunk = std::max<std::size_t>(1, (256 << 10) / frames[0].size());
+  for (std::size_t i = 0; i < total;) {
+    chunk.clear();
+    for (std::size_t k = 0; k < per_chunk && i < total; ++k, ++i)
+      chunk += frames[i & 1];
+    boost::asio::write(s, boost::asio::buffer(chunk));
+  }
+  // 保持连接直到对端关闭
+  char tmp[64];
+  boost::system::error_code ec;
+  s.read_some(boost::asio::buffer(tmp), ec);
+}
+
+// 真实 Redis：流水线 PUBLISH，另一线程读走回复
+static void publisher(const std::string &host, uint16_t port, std::size_t total,
+                      const std::string &payload) {
+  boost::asio::io_context io;
+  tcp::socket s(io);
+  s.connect(tcp::endpoint(boost::asio::ip::address::from_string(host), port));
+  std::thread drain([&s] {
+    std::vector<char> buf(1 << 16);
+    boost::system::error_code ec;
+    while (!ec)
+      s.read_some(boost::asio::buffer(buf), ec);
+  });
+  std::string frames[2] = {encode({"PUBLISH", "events:A", payload}),
+                           encode({"PUBLISH", "events:B", payload})};
+  std::string chunk;
+  for (std::size_t i = 0; i < total;) {
+    chunk.clear();
+    for (std::size_t k = 0; k < 1024 && i < total; ++k, ++i)
+      chunk += frames[i & 1];
+    boost::asio::write(s, boost::asio::buffer(chunk));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  boost::system::error_code ec;
+  s.shutdown(tcp::socket::shutdown_both, ec);
+  drain.join();
+}
+
+int main(int argc, char **argv) {
+  std::size_t total = 2000000;
+  std::size_t payload_size = 64;
+  bool resp3 = false;
+  std::string redis_addr;
+  int pos = 0;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--resp3")
+      resp3 = true;
+    else if (arg == "--redis" && i + 1 < argc)
+      redis_addr = argv[++i];
+    else if (pos++ == 0)
+      total = std::strtoull(argv[i], nullptr, 10);
+    else
+      payload_size = std::strtoull(argv[i], nullptr, 10);
+  }
+  std::string payload(payload_size, 'x');
+
+  boost::asio::io_context io;
+  auto manager = std::make_shared<ClientManager>(io);
+  RedisSubscriberConfig cfg;
+  cfg.resp3 = resp3;
+  cfg.channels = {{"events:A", EventType::EVENT_A}, {"events:B", EventType::EVENT_B}};
+
+  boost::asio::io_context server_io;
+  tcp::acceptor acceptor(server_io, tcp::endpoint(tcp::v4(), 0));
+  std::thread server;
+  if (redis_addr.empty()) {
+    cfg.port = acceptor.local_endpoint().port();
+    server = std::thread([&] { stand_in(acceptor, total, payload, resp3); });
+  } else {
+    auto colon = redis_addr.rfind(':');
+    cfg.host = redis_addr.substr(0, colon);
+    if (colon != std::string::npos)
+      cfg.port = static_cast<uint16_t>(std::stoi(redis_addr.substr(colon + 1)));
+  }
+
+  auto sub = RedisSubscriber::create(io, cfg, manager);
+  sub->start();
+  auto guard = boost::asio::make_work_guard(io);
+  std::thread io_thread([&io] { io.run(); });
+
+  if (!redis_addr.empty()) {
+    // 等订阅生效后再发布，否则早到的消息会被 Redis 丢弃
+    while (!sub->connected())
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    server = std::thread([&] { publisher(cfg.host, cfg.port, total, payload); });
+  }
+
+  using clock = std::chrono::steady_clock;
+  clock::time_point start{};
+  auto deadline = clock::now() + std::chrono::seconds(60);
+  RedisSubscriberStats st;
+  for (;;) {
+    st = sub->stats();
+    if (st.messages > 0 && start == clock::time_point{})
+      start = clock::now();
+    if (st.messages >= total || clock::now() > deadline)
+      break;
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  double secs = std::chrono::duration<double>(clock::now() - start).count();
+
+  std::printf("%s %s payload=%zuB\n", redis_addr.empty() ? "stand-in" : "redis",
+              resp3 ? "RESP3" : "RESP2", payload_size);
+  std::printf("  received %llu / %zu in %.3f s: %.0f msgs/s, %.1f MB/s\n",
+              static_cast<unsigned long long>(st.messages), total, secs,
+              st.messages / secs, st.bytes / secs / 1e6);
+  std::printf("  batches=%llu (%.1f msgs/batch) unmapped=%llu reconnects=%llu\n",
+              static_cast<unsigned long long>(st.batches),
+              st.batches ? double(st.messages) / st.batches : 0.0,
+              static_cast<unsigned long long>(st.unmapped),
+              static_cast<unsigned long long>(st.reconnects));
+
+  sub->stop();
+  guard.reset();
+  io_thread.join();
+  server.join();
+  return st.messages >= total ? 0 : 1;
+}
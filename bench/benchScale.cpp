@@ -0,0 +1,396 @@
+// ClientManager 规模压测：本机回环上的回显服务端群 + 一个 ClientManager
+//
+// 编译: g++ -std=c++20 -O2 -I.. -DASYNC_LOG_LEVEL=4 benchScale.cpp -o benchScale -lpthread
+// 运行: ./benchScale [连接数=1000] [场景=all|steady|burst|storm] [每场景秒数=5]
+//                    [稳态速率 msgs/s=100000] [客户端IO线程=核数] [服务端线程=1]
+//                    [引擎=callback|coroutine]
+//
+// 服务端在 fork 出的子进程里运行，每个端点一个监听：地址 127.0.x.y、端口 7000，
+// 按地址区分端点，5 万个监听也不占用临时端口；每个会话把收到的字节原样写回（逐行回显）。
+// 客户端为每核模式的 ClientManager，每个端点一条 PIPELINED 连接。CPU 与 RSS 只统计
+// 父进程，CPU 再扣除负责采样的主线程，只剩 IO 线程与生产者线程。
+// 每个场景新建一个 ClientManager，先等全部连接建立，然后：
+//   steady  生产者按固定总速率轮流向各连接发送；
+//   burst   每秒一次向每条连接连发 kBurst 条，记录每次突发完全收齐回复的用时；
+//   storm   稳态发送的同时让服务端一次性断开全部会话，记录全部连接重新建立的用时；
+//           回复数与 RTT 只来自重连后的连接（断开的连接统计随之丢弃）。
+// 连接数较大时需提高 ulimit -n（子进程每个端点占 2 个 fd，父进程占 1 个）。
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "clientManager.h"
+
+using boost::asio::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+static constexpr uint16_t kPort = 7000;
+static constexpr std::size_t kBurst = 8;  // burst 场景每条连接每次连发条数
+
+// 第 i 个端点的监听地址，父子进程共用
+static std::string listener_address(std::size_t i) {
+  return "127.0." + std::to_string(1 + i / 250) + "." +
+         std::to_string(1 + i % 250);
+}
+
+static void raise_fd_limit() {
+  rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+  }
+}
+
+static long rss_kb() {
+  std::ifstream in("/proc/self/status");
+  std::string line;
+  while (std::getline(in, line))
+    if (line.compare(0, 6, "VmRSS:") == 0)
+      return std::atol(line.c_str() + 6);
+  return 0;
+}
+
+static double cpu_seconds(int who) {
+  rusage ru;
+  getrusage(who, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+         (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+// 进程 CPU 减去主线程 CPU；已退出线程的 CPU 仍计入 RUSAGE_SELF
+static double worker_cpu_seconds() {
+  return cpu_seconds(RUSAGE_SELF) - cpu_seconds(RUSAGE_THREAD);
+}
+
+template <typename Cond> static bool wait_for(Cond cond, int ms) {
+  for (int i = 0; i < ms && !cond(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  return cond();
+}
+
+// ============ 服务端（子进程） ============
+class EchoSession : public std::enable_shared_from_this<EchoSession> {
+public:
+  explicit EchoSession(tcp::socket s) : socket_(std::move(s)) {}
+  void start() { read(); }
+
+  void close() {
+    auto self = shared_from_this();
+    boost::asio::post(socket_.get_executor(), [self] {
+      boost::system::error_code ec;
+      self->socket_.close(ec);
+    });
+  }
+
+private:
+  void read() {
+    auto self = shared_from_this();
+    socket_.async_read_some(
+        boost::asio::buffer(buf_),
+        [this, self](boost::system::error_code ec, std::size_t n) {
+          if (ec)
+            return;
+          boost::asio::async_write(
+              socket_, boost::asio::buffer(buf_, n),
+              [this, self](boost::system::error_code ec, std::size_t) {
+                if (!ec)
+                  read();
+              });
+        });
+  }
+
+  tcp::socket socket_;
+  char buf_[4096];
+};
+
+class EchoFleet {
+public:
+  EchoFleet(boost::asio::io_context &io) : io_(io), signals_(io, SIGUSR1) {}
+
+  // 返回成功监听的端点数
+  std::size_t listen(std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+      try {
+        tcp::endpoint ep(boost::asio::ip::make_address(listener_address(i)), kPort);
+        acceptors_.emplace_back(new tcp::acceptor(io_, ep));
+      } catch (const std::exception &e) {
+        std::fprintf(stderr, "listen %s:%u failed: %s\n",
+                     listener_address(i).c_str(), kPort, e.what());
+        break;
+      }
+      accept(*acceptors_.back());
+    }
+    wait_signal();
+    return acceptors_.size();
+  }
+
+private:
+  void accept(tcp::acceptor &acc) {
+    acc.async_accept(boost::asio::make_strand(io_),
+                     [this, &acc](boost::system::error_code ec, tcp::socket s) {
+                       if (!ec) {
+                         auto session = std::make_shared<EchoSession>(std::move(s));
+                         {
+                           std::lock_guard<std::mutex> lock(mtx_);
+                           sessions_.push_back(session);
+                         }
+                         session->start();
+                       }
+                       accept(acc);
+                     });
+  }
+
+  // SIGUSR1：断开全部会话，监听保持，模拟服务端重启或网络闪断
+  void wait_signal() {
+    signals_.async_wait([this](boost::system::error_code ec, int) {
+      if (ec)
+        return;
+      std::vector<std::weak_ptr<EchoSession>> all;
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        all.swap(sessions_);
+      }
+      for (auto &w : all)
+        if (auto s = w.lock())
+          s->close();
+      wait_signal();
+    });
+  }
+
+  boost::asio::io_context &io_;
+  boost::asio::signal_set signals_;
+  std::vector<std::unique_ptr<tcp::acceptor>> acceptors_;
+  std::mutex mtx_;
+  std::vector<std::weak_ptr<EchoSession>> sessions_;
+};
+
+static void run_server(std::size_t n, std::size_t threads, int ready_fd) {
+  boost::asio::io_context io;
+  EchoFleet fleet(io);
+  uint32_t bound = static_cast<uint32_t>(fleet.listen(n));
+  if (write(ready_fd, &bound, sizeof(bound)) != sizeof(bound))
+    return;
+  close(ready_fd);
+  std::vector<std::thread> pool;
+  for (std::size_t i = 1; i < threads; ++i)
+    pool.emplace_back([&io] { io.run(); });
+  io.run();
+  for (auto &t : pool)
+    t.join();
+}
+
+// ============ 客户端（父进程） ============
+struct Options {
+  std::size_t conns = 1000;
+  int seconds = 5;
+  std::size_t rate = 100000;
+  std::size_t io_threads = std::max(1u, std::thread::hardware_concurrency());
+  ConnEngine engine = ConnEngine::CALLBACK;
+  pid_t server = 0;
+  long rss_base = 0;
+};
+
+// 按固定总速率轮流向各连接发送，直到 stop；返回被接受的条数
+static uint64_t paced_send(ClientManager &mgr, const std::vector<ConnHandle> &handles,
+                           std::size_t rate, const std::atomic<bool> &stop,
+                           uint64_t &refused) {
+  SharedMessage msg = make_shared_message(std::string("scale-0123456789abcdef\n"));
+  uint64_t sent = 0, accepted = 0;
+  std::size_t next = 0;
+  auto t0 = Clock::now();
+  while (!stop.load(std::memory_order_relaxed)) {
+    double elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+    uint64_t target = static_cast<uint64_t>(elapsed * rate);
+    for (; sent < target; ++sent) {
+      SendResult r = mgr.send_message(handles[next], msg);
+      if (++next == handles.size())
+        next = 0;
+      if (r == SendResult::OK || r == SendResult::DROPPED_OLDEST)
+        ++accepted;
+      else
+        ++refused;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return accepted;
+}
+
+static void run_scenario(const std::string &name, const Options &opt) {
+  IoContextPool pool(opt.io_threads);
+  pool.run(false);
+  auto mgr = std::make_shared<ClientManager>(pool);
+
+  std::vector<ConnHandle> handles;
+  handles.reserve(opt.conns);
+  auto t_connect = Clock::now();
+  for (std::size_t i = 0; i < opt.conns; ++i) {
+    ConnInfo info;
+    info.ip = listener_address(i);
+    info.port = kPort;
+    info.write_mode = WriteMode::PIPELINED;
+    info.read_buffer_size = 4096;
+    info.engine = opt.engine;
+    handles.push_back(mgr->add_connection(info));
+  }
+  if (!wait_for([&] { return mgr->connect_stats().succeeded >= opt.conns; },
+                120000)) {
+    std::printf("%-7s connect timeout: %llu/%zu\n", name.c_str(),
+                static_cast<unsigned long long>(mgr->connect_stats().succeeded),
+                opt.conns);
+    return;
+  }
+  double connect_ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - t_connect).count();
+  long rss_connected = rss_kb();
+
+  double cpu0 = worker_cpu_seconds();
+  auto t0 = Clock::now();
+  uint64_t accepted = 0, refused = 0;
+  char extra[128] = "";
+
+  if (name == "steady" || name == "storm") {
+    std::atomic<bool> stop{false};
+    std::thread producer([&] {
+      accepted = paced_send(*mgr, handles, opt.rate, stop, refused);
+    });
+    if (name == "storm") {
+      // 稳态 1 秒后断开全部会话，等全部连接重新建立
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+      uint64_t before = mgr->connect_stats().succeeded;
+      auto t_storm = Clock::now();
+      kill(opt.server, SIGUSR1);
+      bool ok = wait_for(
+          [&] { return mgr->connect_stats().succeeded >= before + opt.conns; },
+          120000);
+      double recover_ms =
+          std::chrono::duration<double, std::milli>(Clock::now() - t_storm).count();
+      ConnectStats cs = mgr->connect_stats();
+      std::snprintf(extra, sizeof(extra), "recover=%.0fms%s fail=%llu peakq=%zu",
+                    recover_ms, ok ? "" : "(timeout)",
+                    static_cast<unsigned long long>(cs.failed), cs.peak_queued);
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+    } else {
+      std::this_thread::sleep_for(std::chrono::seconds(opt.seconds));
+    }
+    stop = true;
+    producer.join();
+  } else {  // burst
+    SharedMessage msg = make_shared_message(std::string("burst-0123456789abcdef\n"));
+    double drain_sum = 0, drain_max = 0;
+    for (int b = 0; b < opt.seconds; ++b) {
+      auto t_burst = Clock::now();
+      uint64_t base = mgr->reply_count();
+      uint64_t n = 0;
+      std::thread producer([&] {
+        for (std::size_t k = 0; k < kBurst; ++k)
+          for (ConnHandle h : handles) {
+            SendResult r = mgr->send_message(h, msg);
+            if (r == SendResult::OK || r == SendResult::DROPPED_OLDEST)
+              ++n;
+            else
+              ++refused;
+          }
+      });
+      producer.join();
+      accepted += n;
+      wait_for([&] { return mgr->reply_count() >= base + n; }, 30000);
+      double ms =
+          std::chrono::duration<double, std::milli>(Clock::now() - t_burst).count();
+      drain_sum += ms;
+      drain_max = std::max(drain_max, ms);
+      std::this_thread::sleep_until(t_burst + std::chrono::seconds(1));
+    }
+    std::snprintf(extra, sizeof(extra), "drain avg=%.1fms max=%.1fms",
+                  drain_sum / std::max(opt.seconds, 1), drain_max);
+  }
+
+  // 等在途消息收齐；storm 中断开连接上的回复已不可得，只等有限时间
+  uint64_t target = accepted;
+  wait_for([&] { return mgr->reply_count() >= target; }, 3000);
+  double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+  double cpu = worker_cpu_seconds() - cpu0;
+  LatencySummary rtt = mgr->rtt_stats();
+  long rss_end = rss_kb();
+
+  std::printf("%-7s %6zu %8.0f %9llu %9.0f %7.0f %7.0f %7.0f %8.0f %7.2f %7.1f %7.1f %6llu  %s\n",
+              name.c_str(), opt.conns, connect_ms,
+              static_cast<unsigned long long>(rtt.count), rtt.count / sec,
+              rtt.p50_us, rtt.p99_us, rtt.p999_us, rtt.max_us,
+              rtt.count ? cpu * 1e6 / rtt.count : 0.0,
+              static_cast<double>(rss_connected - opt.rss_base) / opt.conns,
+              static_cast<double>(rss_end - opt.rss_base) / opt.conns,
+              static_cast<unsigned long long>(refused), extra);
+  std::fflush(stdout);
+  pool.stop();
+  pool.join();
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (argc > 1)
+    opt.conns = std::max<std::size_t>(1, std::strtoul(argv[1], nullptr, 10));
+  std::string which = argc > 2 ? argv[2] : "all";
+  if (argc > 3)
+    opt.seconds = std::max(1, std::atoi(argv[3]));
+  if (argc > 4)
+    opt.rate = std::strtoul(argv[4], nullptr, 10);
+  if (argc > 5)
+    opt.io_threads = std::max<std::size_t>(1, std::strtoul(argv[5], nullptr, 10));
+  std::size_t server_threads =
+      argc > 6 ? std::max<std::size_t>(1, std::strtoul(argv[6], nullptr, 10)) : 1;
+  if (argc > 7 && std::string(argv[7]) == "coroutine")
+    opt.engine = ConnEngine::COROUTINE;
+
+  raise_fd_limit();
+  int fds[2];
+  if (pipe(fds) != 0) {
+    std::perror("pipe");
+    return 1;
+  }
+  // 在创建任何线程之前 fork
+  pid_t child = fork();
+  if (child == 0) {
+    close(fds[0]);
+    run_server(opt.conns, server_threads, fds[1]);
+    _exit(0);
+  }
+  close(fds[1]);
+  uint32_t bound = 0;
+  if (read(fds[0], &bound, sizeof(bound)) != sizeof(bound) || bound == 0) {
+    std::fprintf(stderr, "server failed to start\n");
+    kill(child, SIGKILL);
+    waitpid(child, nullptr, 0);
+    return 1;
+  }
+  close(fds[0]);
+  opt.conns = std::min<std::size_t>(opt.conns, bound);
+  opt.server = child;
+  opt.rss_base = rss_kb();
+
+  std::printf("conns=%zu io_threads=%zu server_threads=%zu rate=%zu msgs/s burst=%zu engine=%s\n",
+              opt.conns, opt.io_threads, server_threads, opt.rate, kBurst,
+              opt.engine == ConnEngine::COROUTINE ? "coroutine" : "callback");
+  std::printf("%-7s %6s %8s %9s %9s %7s %7s %7s %8s %7s %7s %7s %6s  %s\n",
+              "case", "conns", "conn_ms", "replies", "msgs/s", "p50us",
+              "p99us", "p999us", "maxus", "cpu_us", "kb/conn", "kb_end",
+              "refuse", "notes");
+  for (const char *name : {"steady", "burst", "storm"})
+    if (which == "all" || which == name)
+      run_scenario(name, opt);
+
+  kill(child, SIGTERM);
+  waitpid(child, nullptr, 0);
+  return 0;
+}
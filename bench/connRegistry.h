@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// ============ ShardedRegistry =============
+// 按 key 哈希分片的并发注册表，每个分片独立一把读写锁：
+//   - 查找/发送只对一个分片加共享锁，不同线程的查找互不阻塞；
+//   - 插入/删除只对一个分片加独占锁，只影响落在同一分片的 key；
+//   - for_each 逐个分片加共享锁遍历，任一时刻最多持有一个分片，
+//     遍历期间其它线程的查找/发送照常进行。
+// ClientManager 已改用 SlotTable（见 slotTable.h），此类只留作 benchRegistry 的对照实现。
+template <typename V, std::size_t Shards = 32>
+class ShardedRegistry {
+public:
+  void insert_or_assign(const std::string &key, V value) {
+    Shard &s = shard_for(key);
+    std::unique_lock<std::shared_mutex> lock(s.mtx);
+    s.map[key] = std::move(value);
+  }
+
+  bool erase(const std::string &key) {
+    Shard &s = shard_for(key);
+    std::unique_lock<std::shared_mutex> lock(s.mtx);
+    return s.map.erase(key) > 0;
+  }
+
+  // 拷贝出值（对 shared_ptr 来说是一次引用计数增加）
+  bool find(const std::string &key, V &out) const {
+    const Shard &s = shard_for(key);
+    std::shared_lock<std::shared_mutex> lock(s.mtx);
+    auto it = s.map.find(key);
+    if (it == s.map.end())
+      return false;
+    out = it->second;
+    return true;
+  }
+
+  // 在分片共享锁内对值调用 f，避免拷贝；f 内不得再修改本注册表
+  template <typename F> bool visit(const std::string &key, F &&f) const {
+    const Shard &s = shard_for(key);
+    std::shared_lock<std::shared_mutex> lock(s.mtx);
+    auto it = s.map.find(key);
+    if (it == s.map.end())
+      return false;
+    f(it->second);
+    return true;
+  }
+
+  // f(const std::string &key, const V &value)；f 内不得再修改本注册表
+  template <typename F> void for_each(F &&f) const {
+    for (const Shard &s : shards_) {
+      std::shared_lock<std::shared_mutex> lock(s.mtx);
+      for (const auto &kv : s.map)
+        f(kv.first, kv.second);
+    }
+  }
+
+  std::vector<std::string> keys() const {
+    std::vector<std::string> out;
+    for_each([&out](const std::string &k, const V &) { out.push_back(k); });
+    return out;
+  }
+
+  std::size_t size() const {
+    std::size_t n = 0;
+    for (const Shard &s : shards_) {
+      std::shared_lock<std::shared_mutex> lock(s.mtx);
+      n += s.map.size();
+    }
+    return n;
+  }
+
+private:
+  // 分片按缓存行对齐，避免相邻分片的锁伪共享
+  struct alignas(64) Shard {
+    mutable std::shared_mutex mtx;
+    std::unordered_map<std::string, V> map;
+  };
+
+  Shard &shard_for(const std::string &key) {
+    return shards_[std::hash<std::string>{}(key) % Shards];
+  }
+  const Shard &shard_for(const std::string &key) const {
+    return shards_[std::hash<std::string>{}(key) % Shards];
+  }
+
+  std::array<Shard, Shards> shards_;
+};
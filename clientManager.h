@@ -0,0 +1,2275 @@
+#pragma once
+
+#include <utility>  // 须先于 asio 引入，见 connCoroutine.h
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <boost/circular_buffer.hpp>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "asyncLogger.h"
+#include "connCoroutine.h"
+#include "connectLimiter.h"
+#include "handlerAllocator.h"
+#include "ioContextPool.h"
+#include "latencyHistogram.h"
+#include "lineFramer.h"
+#include "memberList.h"
+#include "mpscQueue.h"
+#include "slotTable.h"
+#include "spillStore.h"
+#include "timingWheel.h"
+
+// ============ 事件类型 ============
+enum class EventType { EVENT_A, EVENT_B, EVENT_C };
+constexpr std::size_t kEventTypeCount = 3;
+
+// ============ 共享消息缓冲 ============
+// 不可变、引用计数的消息体：广播时只分配一次，由所有连接队列共享，
+// 入队/出队只增减引用计数，不再逐连接拷贝字节
+using SharedMessage = std::shared_ptr<const std::vector<uint8_t>>;
+
+inline SharedMessage make_shared_message(std::vector<uint8_t> data) {
+  return std::make_shared<const std::vector<uint8_t>>(std::move(data));
+}
+
+inline SharedMessage make_shared_message(const std::string &data) {
+  return make_shared_message(std::vector<uint8_t>(data.begin(), data.end()));
+}
+
+// 消息体去掉行尾换行后的视图（日志、合并 key 与请求 id 提取都按此解析），指向 data 内部
+inline std::string_view body_view(const std::vector<uint8_t> &data) {
+  std::size_t len = (!data.empty() && data.back() == '\n') ? data.size() - 1 : data.size();
+  return std::string_view(reinterpret_cast<const char *>(data.data()), len);
+}
+
+// ============ RingQueue =============
+// 满时容量翻倍的 circular_buffer。std::deque 每跨过一个块就释放/申请一次内存，
+// 环形队列容量到稳态后 push/pop 不再分配
+template <typename T> class RingQueue : public boost::circular_buffer<T> {
+public:
+  void push_back(T v) {
+    if (this->full())
+      this->set_capacity(std::max<std::size_t>(16, this->capacity() * 2));
+    boost::circular_buffer<T>::push_back(std::move(v));
+  }
+};
+
+// ============ BufferSpan =============
+// 指向外部缓冲数组的 ConstBufferSequence。async_write 会按值保存缓冲序列，
+// 直接传 std::vector 每次写都会复制一遍 vector（一次堆分配），传视图则不会
+struct BufferSpan {
+  using value_type = boost::asio::const_buffer;
+  using const_iterator = const boost::asio::const_buffer *;
+
+  const_iterator first;
+  const_iterator last;
+
+  const_iterator begin() const { return first; }
+  const_iterator end() const { return last; }
+};
+
+// ============ 事件消息 ============
+struct EventMsg {
+  SharedMessage data;
+};
+
+// 事件合并：从事件体（不含换行）中取出合并 key，返回值须指向事件体内部；
+// 返回空表示该条不参与合并
+using ConflationKeyFn = std::function<std::string_view(std::string_view event)>;
+
+// 成批投递的事件：(类型, 事件体)，事件体以换行结尾
+using EventBatch = std::vector<std::pair<EventType, SharedMessage>>;
+
+// ============ 写模式 ============
+// PING_PONG：写一条、等设备回一行再写下一条（适合只能串行应答的设备）
+// PIPELINED：允许最多 max_inflight 条消息未收到回复，吞吐受带宽而非 RTT 限制
+enum class WriteMode { PING_PONG, PIPELINED };
+
+// ============ 背压策略 ============
+// 待发送消息数（含未下发事件）达到高水位后进入背压状态，
+// 直到写出到低水位以下才解除；背压期间新消息按策略处理
+enum class BackpressurePolicy {
+  DROP_OLDEST,  // 接收新消息，丢弃最旧的一条未发送消息
+  DROP_NEWEST,  // 丢弃新消息
+  REJECT,       // 拒绝新消息，由调用方降速/重试
+  DISCONNECT,   // 断开（并按重连策略重连）卡住的设备
+};
+
+// ============ 入队结果 ============
+enum class SendResult {
+  OK,              // 已入队
+  DROPPED_OLDEST,  // 已入队，但挤掉了最旧的一条未发送消息
+  DROPPED,         // 背压中，本条被丢弃
+  REJECTED,        // 背压中，拒绝入队
+  DISCONNECTED,    // 背压中，连接已被断开
+  NO_CONNECTION,   // 目标不在线
+  SPILLED,         // 已写入磁盘溢出队列，之后按序补发
+  CONFLATED,       // 原地覆盖了同 key 尚未下发的旧值，队列深度不变
+};
+
+// 生产者应降速的结果
+inline bool is_backpressure(SendResult r) {
+  return r != SendResult::OK && r != SendResult::NO_CONNECTION &&
+         r != SendResult::SPILLED && r != SendResult::CONFLATED;
+}
+
+// ============ 请求/应答 ============
+using RequestId = uint64_t;  // 0 表示未发出
+
+enum class RequestStatus {
+  OK,            // 收到对应回复
+  TIMEOUT,       // 截止时间内未收到回复
+  DISCONNECTED,  // 完成前连接断开（含尚未写出的）
+  DROPPED,       // 尚未写出即被 DROP_OLDEST 挤掉
+  CANCELLED,     // 被 cancel_request 取消
+  DUPLICATE,     // 按 id 对应时，同一 id 已有请求在途（该请求不发出）
+};
+
+// 在连接的 strand 上执行，应尽快返回；reply 为回复行（不含换行），只在回调期间有效
+using ReplyCallback = std::function<void(RequestStatus, std::string_view reply)>;
+
+// 从请求消息或回复行中提取对应 id（不能为 0），提取不到返回 false
+using CorrelationFn = std::function<bool(std::string_view line, RequestId &id)>;
+
+// accepted() 为真时回调恰好执行一次，否则不会执行，result 说明原因
+struct RequestTicket {
+  SendResult result = SendResult::NO_CONNECTION;
+  RequestId id = 0;
+  bool accepted() const { return id != 0; }
+};
+
+struct RequestStats {
+  std::size_t outstanding = 0;  // 已接收、尚未完成的请求
+  uint64_t completed = 0;       // 收到回复
+  uint64_t timed_out = 0;
+  uint64_t failed = 0;          // 断线、丢弃、取消或 id 重复
+};
+
+// ============ 发送通道 ============
+// 每条连接的待发送消息按优先级分通道（lane）排队：
+// CONTROL 心跳、告警等控制消息，不受高水位限制，DROP_OLDEST 也不丢弃；
+// NORMAL 普通发送、请求与事件（默认）；BULK 可让路的批量数据
+enum class Lane : uint8_t { CONTROL, NORMAL, BULK };
+constexpr std::size_t kLaneCount = 3;
+
+// STRICT：总是先取优先级最高的非空通道
+// WEIGHTED：各非空通道按 lane_weights 的条数比例轮流取，低优先级不会饿死
+enum class LaneScheduling { STRICT, WEIGHTED };
+
+// 待发送队列中的一条；请求带非 0 的 req
+struct OutMsg {
+  SharedMessage data;
+  RequestId req = 0;
+  Lane lane = Lane::NORMAL;
+};
+
+// ============ 连接引擎 ============
+// CALLBACK：回调链驱动读写（默认）
+// COROUTINE：读、写各一个常驻协程，需 C++20，否则退回 CALLBACK
+enum class ConnEngine { CALLBACK, COROUTINE };
+
+// ============ 端点组路由 ============
+// QUEUE_DEPTH：待发送消息最少的成员
+// RTT：预计排空时间 (待发送数 + 1) * 平滑往返时延最小的成员，尚无样本的按 0 计
+enum class GroupRouting { QUEUE_DEPTH, RTT };
+
+// ============ 连接参数结构 ============
+struct ConnInfo {
+  std::string ip;
+  uint16_t port;
+  bool auto_reconnect = true;
+  std::vector<EventType> event_types{EventType::EVENT_A};  // 订阅的事件类型，可多个
+  WriteMode write_mode = WriteMode::PING_PONG;
+  std::size_t max_inflight = 16;  // 仅 PIPELINED 模式生效
+  std::size_t max_batch_msgs = 64;          // 单次聚合写最多消息数
+  std::size_t max_batch_bytes = 64 * 1024;  // 单次聚合写最多字节数
+  // 事件攒批：首个事件到达后最多等待 event_batch_delay 再下发，
+  // 攒够 event_batch_max 条立即下发；delay 为 0 表示逐个立即下发
+  std::chrono::milliseconds event_batch_delay{2};
+  std::size_t event_batch_max = 64;
+  std::size_t read_buffer_size = 64 * 1024;  // 读缓冲区大小，也是单行回复的最大长度
+  std::size_t high_watermark = 10000;  // 待发送消息上限，0 表示不限
+  std::size_t low_watermark = 5000;
+  BackpressurePolicy backpressure = BackpressurePolicy::REJECT;
+  ConnEngine engine = ConnEngine::CALLBACK;
+  // 为空时请求按发送顺序对应回复；非空时按它从请求消息和回复行中提取的 id 对应。
+  // 不参与热重载比较，更换时需先删除端点再添加
+  CorrelationFn correlate;
+  // 非空时加入同名端点组，send_to_group 在组内在线成员中择优发送。
+  // 组与路由方式变化不重建连接；组内各成员的 group_routing 应一致，以最后建连者为准
+  std::string group;
+  GroupRouting group_routing = GroupRouting::QUEUE_DEPTH;
+  LaneScheduling lane_scheduling = LaneScheduling::STRICT;
+  std::array<unsigned, kLaneCount> lane_weights{16, 4, 1};  // 仅 WEIGHTED 生效
+  // 非空时启用磁盘溢出（见 SpillStore）：离线期间发往本端点的消息与订阅的事件、
+  // 断开时已写出未获应答及尚未写出的消息、高水位以上的新消息写入该目录，
+  // 重连或队列回落后按序补发。已写出未获应答的消息设备可能已处理，补发后会重复（至少一次）。
+  // CONTROL 通道与请求不溢出。不参与热重载比较，更换时需先删除端点再添加
+  std::string spill_dir;
+  std::size_t spill_segment_bytes = 4 << 20;
+  std::size_t spill_max_bytes = 256 << 20;
+};
+
+// ============ 重连退避策略 ============
+// 第 n 次重连的退避上限为 min(max, initial * multiplier^n)，实际等待取
+// [上限/2, 上限] 内的随机值（等量抖动），避免大量连接在同一时刻重拨
+struct ReconnectPolicy {
+  std::chrono::milliseconds initial{500};
+  std::chrono::milliseconds max{30000};
+  double multiplier = 2.0;
+  std::size_t max_concurrent_connects = 256;  // 全局同时在途的 async_connect 上限
+  std::chrono::milliseconds connect_timeout{5000};
+};
+
+// 除订阅和 auto_reconnect 之外的参数在建连时固化进 Connection，
+// 这些参数变化时热重载需要重建连接
+inline bool same_link_params(const ConnInfo &a, const ConnInfo &b) {
+  return a.ip == b.ip && a.port == b.port && a.write_mode == b.write_mode &&
+         a.max_inflight == b.max_inflight &&
+         a.max_batch_msgs == b.max_batch_msgs &&
+         a.max_batch_bytes == b.max_batch_bytes &&
+         a.event_batch_delay == b.event_batch_delay &&
+         a.event_batch_max == b.event_batch_max &&
+         a.read_buffer_size == b.read_buffer_size &&
+         a.high_watermark == b.high_watermark &&
+         a.low_watermark == b.low_watermark &&
+         a.backpressure == b.backpressure && a.engine == b.engine &&
+         a.lane_scheduling == b.lane_scheduling &&
+         a.lane_weights == b.lane_weights;
+}
+
+// ============ 热重载结果 ============
+struct ReloadStats {
+  std::size_t added = 0;         // 新增并建连
+  std::size_t removed = 0;       // 已从配置中删除并关闭
+  std::size_t reopened = 0;      // 链路参数变化，重建连接
+  std::size_t resubscribed = 0;  // 仅订阅变化，连接保持
+  std::size_t regrouped = 0;     // 仅端点组变化，连接保持
+  std::size_t unchanged = 0;
+};
+
+// ============ 事件路由结果 ============
+struct EventRouteResult {
+  std::size_t subscribers = 0;
+  std::size_t accepted = 0;      // 含 DROPPED_OLDEST
+  std::size_t dropped = 0;       // DROP_NEWEST 丢弃
+  std::size_t rejected = 0;
+  std::size_t disconnected = 0;  // 含恰好断开、尚未摘除的订阅连接
+  std::size_t dropped_oldest = 0;
+  std::size_t conflated = 0;     // 覆盖了同 key 的未下发旧值（计入 accepted）
+  std::size_t spilled = 0;       // 写入溢出队列，含离线端点（计入 accepted）
+
+  bool backpressured() const {
+    return dropped || rejected || disconnected || dropped_oldest;
+  }
+};
+
+// ============ 队列统计 ============
+struct QueueStats {
+  std::size_t depth = 0;  // 待发送消息数（含未下发事件）
+  std::array<std::size_t, kLaneCount> lane_depth{};  // 按通道分，下标为 Lane
+  bool backpressured = false;
+  uint64_t dropped = 0;   // 因背压丢弃的消息（新或旧）
+  uint64_t rejected = 0;
+  uint64_t conflated = 0;  // 被同 key 新值覆盖而未下发的事件
+};
+
+// ============ 写统计 ============
+struct WriteStats {
+  uint64_t batches = 0;         // async_write 次数
+  uint64_t messages = 0;        // 写出的消息总数
+  uint64_t bytes = 0;           // 写出的字节总数
+  uint64_t max_batch = 0;       // 单次聚合的最大消息数
+  uint64_t syscalls_saved = 0;  // 相比逐条写少发起的写操作数
+
+  double avg_batch() const {
+    return batches ? static_cast<double>(messages) / batches : 0.0;
+  }
+};
+
+// ============ Connection =============
+class Connection : public std::enable_shared_from_this<Connection> {
+public:
+  using Ptr = std::shared_ptr<Connection>;
+  using Message = std::vector<uint8_t>;
+  using MessageQueue = RingQueue<OutMsg>;
+  // 参数为断开的连接与 need_reconnect；端点身份由回调自身捕获（ClientManager 捕获句柄），
+  // 连接指针用于判断该端点当前是否仍是这条连接（重建后旧连接的迟到回调应忽略）
+  using DisconnectCallback = std::function<void(Connection *, bool)>;
+
+  friend class SubscriptionIndex;  // 维护 sub_pos_
+  friend class GroupIndex;         // 维护 group_id_ / group_pos_
+
+  // wheel 提供攒批与请求超时定时；连接持有一份引用，管理器先析构时
+  // 迟到的回复与定时器回调仍可安全访问时间轮
+  static Ptr create(boost::asio::io_context &io, const std::string &key,
+                    const ConnInfo &info, TimingWheel::Ptr wheel) {
+    return Ptr(new Connection(io, key, info, std::move(wheel), IoContextPool::Lease()));
+  }
+
+  // 每核模式：连接固定在 lease 所指的 io_context 上，析构时归还名额
+  static Ptr create(IoContextPool::Lease lease, const std::string &key,
+                    const ConnInfo &info, TimingWheel::Ptr wheel) {
+    boost::asio::io_context &io = lease.context();
+    return Ptr(new Connection(io, key, info, std::move(wheel), std::move(lease)));
+  }
+
+  boost::asio::ip::tcp::socket &socket() { return socket_; }
+
+  using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
+  const Strand &strand() const { return strand_; }
+
+  // 连接已关闭（尚未从索引中摘除）时返回 NO_CONNECTION，调用方可改投他处
+  SendResult push_message(SharedMessage msg, Lane lane = Lane::NORMAL) {
+    if (closed())
+      return SendResult::NO_CONNECTION;
+    if (should_spill(lane))
+      return spill_message(*msg, lane);
+    SendResult r = admit(lane);
+    if (r != SendResult::OK && r != SendResult::DROPPED_OLDEST)
+      return r;
+    to_inbox(OutMsg{std::move(msg), 0, lane}, nullptr);
+    return r;
+  }
+
+  // 请求入队，回复、超时（timeout 为 0 表示不设）或失败时在 strand 上回调 cb
+  RequestTicket push_request(SharedMessage msg, std::chrono::milliseconds timeout,
+                             ReplyCallback cb, Lane lane = Lane::NORMAL) {
+    RequestTicket t;
+    if (closed())
+      return t;
+    RequestId id = 0;
+    if (correlate_) {
+      if (!correlate_(body_view(*msg), id) || id == 0) {
+        t.result = SendResult::REJECTED;
+        return t;
+      }
+    }
+    t.result = admit(lane);
+    if (t.result != SendResult::OK && t.result != SendResult::DROPPED_OLDEST)
+      return t;
+    if (!correlate_)
+      id = next_request_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+    t.id = id;
+    outstanding_.fetch_add(1, std::memory_order_relaxed);
+    NewRequest req{id, timeout, std::move(cb)};
+    to_inbox(OutMsg{std::move(msg), id, lane}, &req);
+    return t;
+  }
+
+  // 异步取消；请求已完成时无效果
+  void cancel_request(RequestId id) {
+    auto self = shared_from_this();
+    boost::asio::post(strand_, [this, self, id]() {
+      finish_request(id, RequestStatus::CANCELLED, {});
+    });
+  }
+
+  RequestStats request_stats() const {
+    RequestStats st;
+    st.outstanding = outstanding_.load(std::memory_order_relaxed);
+    st.completed = stat_req_completed_.load(std::memory_order_relaxed);
+    st.timed_out = stat_req_timeout_.load(std::memory_order_relaxed);
+    st.failed = stat_req_failed_.load(std::memory_order_relaxed);
+    return st;
+  }
+
+  SendResult push_message(const Message &msg, Lane lane = Lane::NORMAL) {
+    return push_message(make_shared_message(msg), lane);
+  }
+
+  // notify 为 false 时不回调 on_disconnect_（调用方已自行接管后续处理）
+  void close(bool need_reconnect = false, bool notify = true) {
+    auto self = shared_from_this();
+    boost::asio::post(strand_, [this, self, need_reconnect, notify]() {
+      if (dead_)
+        return;
+      dead_ = true;
+      closed_.store(true, std::memory_order_relaxed);
+      boost::system::error_code ec;
+      socket_.close(ec);
+      wake_loops();
+      spill_pending();
+      fail_requests();
+      if (notify && on_disconnect_)
+        on_disconnect_(this, need_reconnect);
+    });
+  }
+
+  void set_disconnect_callback(DisconnectCallback cb) {
+    on_disconnect_ = std::move(cb);
+  }
+
+  // 同一端点的各代连接共用一个溢出队列，须在 start() 之前设置
+  void set_spill(std::shared_ptr<SpillStore> spill) { spill_ = std::move(spill); }
+
+  // 溢出队列由空变非空后调用：写循环可能已空闲，由 strand 主动取回
+  void resume_spill() {
+    auto self = shared_from_this();
+    boost::asio::post(strand_, [this, self]() {
+      refill_from_spill();
+      do_write();
+    });
+  }
+
+  // 在 strand 上调用：建连成功。起点为写，消息推送后会自动循环写读；
+  // 协程引擎在此启动常驻的读写循环
+  void start() {
+    started_ = true;
+#ifdef CLIENT_HAS_COROUTINES
+    if (coroutine_) {
+      write_loop();
+      read_loop();
+    }
+#endif
+    // 补发离线期间积压在磁盘上的消息
+    if (spill_ && !spill_->empty())
+      do_write();
+  }
+
+  // 建连超时：尚未 start() 时关闭 socket，在途的 async_connect 随即失败
+  void abort_connect() {
+    auto self = shared_from_this();
+    boost::asio::post(strand_, [this, self]() {
+      if (started_)
+        return;
+      boost::system::error_code ec;
+      socket_.close(ec);
+    });
+  }
+
+  std::string key() const { return conn_key_; }
+
+  WriteMode write_mode() const { return write_mode_; }
+
+  QueueStats queue_stats() const {
+    QueueStats st;
+    st.depth = queued_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < kLaneCount; ++i)
+      st.lane_depth[i] = lane_queued_[i].load(std::memory_order_relaxed);
+    st.backpressured = backpressured();
+    st.dropped = stat_dropped_.load(std::memory_order_relaxed);
+    st.rejected = stat_rejected_.load(std::memory_order_relaxed);
+    st.conflated = stat_conflated_.load(std::memory_order_relaxed);
+    return st;
+  }
+
+  // 可在任意线程调用，计数为近似快照
+  WriteStats write_stats() const {
+    WriteStats st;
+    st.batches = stat_batches_.load(std::memory_order_relaxed);
+    st.messages = stat_messages_.load(std::memory_order_relaxed);
+    st.bytes = stat_bytes_.load(std::memory_order_relaxed);
+    st.max_batch = stat_max_batch_.load(std::memory_order_relaxed);
+    st.syscalls_saved = st.messages - st.batches;
+    return st;
+  }
+
+  // 自本次连接建立起的往返时延（写出 -> 收到对应回复行）
+  LatencySnapshot rtt_snapshot() const { return rtt_.snapshot(); }
+
+  // 自本次连接建立起收到的回复行数，比 rtt_snapshot() 廉价
+  uint64_t replies() const { return rtt_.count(); }
+
+  // 可在任意线程调用：已关闭，不再接收新消息
+  bool closed() const { return closed_.load(std::memory_order_relaxed); }
+
+  // 端点组路由用的廉价负载读数，均为近似值
+  std::size_t queue_depth() const { return queued_.load(std::memory_order_relaxed); }
+  // 溢出队列非空时新消息都写入磁盘（见 should_spill），同样视为背压
+  bool backpressured() const {
+    return over_high_.load(std::memory_order_relaxed) || (spill_ && !spill_->empty());
+  }
+  uint64_t rtt_estimate_us() const { return rtt_ewma_us_.load(std::memory_order_relaxed); }
+
+  // 线程安全地将事件消息压入本连接队列，并在本连接 strand 上安排下发：
+  // 批次内首个事件启动攒批定时器，攒满 event_batch_max 条则立即下发。
+  // 生产者只做一次无锁入队，不会阻塞在 IO 线程上
+  SendResult enqueue_event(EventMsg msg) {
+    if (closed())
+      return SendResult::NO_CONNECTION;
+    if (should_spill(Lane::NORMAL))
+      return spill_message(*msg.data, Lane::NORMAL);
+    SendResult r = admit(Lane::NORMAL);
+    if (r != SendResult::OK && r != SendResult::DROPPED_OLDEST)
+      return r;
+    bool first = event_msgs_.push(std::move(msg));
+    // 攒满后、下发之前继续到来的事件各自再安排一次下发，多出的下发遇到空队列即返回；
+    // event_batch_max 为 1 时首个事件即攒满
+    bool full = event_msgs_.size_approx() >= event_batch_max_;
+    if (!first && !full)
+      return r;
+    auto self = shared_from_this();
+    boost::asio::post(strand_, make_alloc_handler(post_mem_, [this, self, full]() {
+      if (dead_)
+        return;
+      if (full || event_batch_delay_.count() == 0) {
+        if (event_timer_id_) {
+          wheel_->cancel(event_timer_id_);
+          event_timer_id_ = 0;
+        }
+        flush_events();
+        return;
+      }
+      if (event_timer_id_)
+        return;
+      // 时间轮回调不在本连接 strand 上，转回 strand 再下发；
+      // 与 cancel 竞争时可能多下发一次，至多提前清空一批，无副作用
+      event_timer_id_ = wheel_->schedule(event_batch_delay_, [this, self]() {
+        boost::asio::post(strand_, make_alloc_handler(post_mem_, [this, self]() {
+          event_timer_id_ = 0;
+          if (!dead_)
+            flush_events();
+        }));
+      });
+    }));
+    return r;
+  }
+
+  // 合并模式的事件：同类型同 key 尚未下发的旧值被原地覆盖，队列深度只随
+  // 不同 key 的个数增长。待合并的事件在 NORMAL 通道快要写空时才整批移入，
+  // 慢速设备因此只会收到每个 key 的最新值
+  SendResult enqueue_conflated(EventType type, std::string_view key, SharedMessage msg) {
+    if (closed())
+      return SendResult::NO_CONNECTION;
+    if (should_spill(Lane::NORMAL))
+      return spill_message(*msg, Lane::NORMAL);
+    uint64_t hash = std::hash<std::string_view>{}(key) ^
+                    (static_cast<uint64_t>(type) * 0x9e3779b97f4a7c15ULL);
+    SharedMessage old;  // 被覆盖的旧值在锁外释放
+    SendResult r = SendResult::CONFLATED;
+    bool first = false, collided = false;
+    {
+      std::lock_guard<std::mutex> lock(conflate_mtx_);
+      auto it = conflate_index_.find(hash);
+      if (it == conflate_index_.end()) {
+        r = admit(Lane::NORMAL);
+        if (r != SendResult::OK && r != SendResult::DROPPED_OLDEST)
+          return r;
+        first = conflate_pending_.empty();
+        conflate_index_.emplace(hash, conflate_pending_.size());
+        conflate_pending_.push_back(ConflatedEvent{type, std::string(key), std::move(msg)});
+        conflate_size_.store(conflate_pending_.size(), std::memory_order_relaxed);
+      } else if (conflate_pending_[it->second].type == type &&
+                 conflate_pending_[it->second].key == key) {
+        old = std::move(conflate_pending_[it->second].data);
+        conflate_pending_[it->second].data = std::move(msg);
+        stat_conflated_.fetch_add(1, std::memory_order_relaxed);
+        return r;
+      } else {
+        collided = true;  // 极少见的哈希冲突
+      }
+    }
+    if (collided)
+      return enqueue_event(EventMsg{std::move(msg)});  // 冲突的一条按普通事件下发
+    if (first) {
+      auto self = shared_from_this();
+      boost::asio::post(strand_, [this, self]() {
+        if (!dead_)
+          do_write();
+      });
+    }
+    return r;
+  }
+
+private:
+  struct ConflatedEvent {
+    EventType type;
+    std::string key;
+    SharedMessage data;
+  };
+
+  struct NewRequest {
+    RequestId id;
+    std::chrono::milliseconds timeout;
+    ReplyCallback cb;
+  };
+
+  struct PendingRequest {
+    ReplyCallback cb;
+    TimingWheel::TimerId timer = 0;
+  };
+
+  struct Awaiting {
+    std::chrono::steady_clock::time_point sent;
+    RequestId req;  // 0 表示普通消息
+    SharedMessage data;  // 断开时未获应答的写入溢出队列，见 spill_pending
+    Lane lane;
+  };
+
+  Connection(boost::asio::io_context &io, const std::string &key,
+             const ConnInfo &info, TimingWheel::Ptr wheel,
+             IoContextPool::Lease lease)
+      : socket_(io), strand_(boost::asio::make_strand(io)),
+        framer_(std::max<std::size_t>(info.read_buffer_size, 64)), writing_(false),
+        reading_(false), dead_(false), inflight_(0),
+        window_(info.write_mode == WriteMode::PIPELINED
+                    ? std::max<std::size_t>(info.max_inflight, 1)
+                    : 1),
+        max_batch_msgs_(std::max<std::size_t>(info.max_batch_msgs, 1)),
+        max_batch_bytes_(info.max_batch_bytes), conn_key_(key),
+        write_mode_(info.write_mode), wheel_(std::move(wheel)),
+        event_batch_delay_(info.event_batch_delay),
+        event_batch_max_(std::max<std::size_t>(info.event_batch_max, 1)),
+        high_watermark_(info.high_watermark),
+        low_watermark_(std::min(info.low_watermark, info.high_watermark)),
+        policy_(info.backpressure), lease_(std::move(lease)),
+        correlate_(info.correlate), lane_scheduling_(info.lane_scheduling) {
+    for (std::size_t i = 0; i < kLaneCount; ++i)
+      lane_weights_[i] = std::max(info.lane_weights[i], 1u);
+    sub_pos_.fill(kNotListed);
+#ifdef CLIENT_HAS_COROUTINES
+    coroutine_ = info.engine == ConnEngine::COROUTINE;
+#endif
+  }
+
+  // 生产者线程调用：按水位和策略决定是否接收一条新消息，接收则计入 queued_
+  // 与所在通道的计数。多个生产者并发时可能略超高水位，偏差不超过并发数；
+  // CONTROL 通道总是接收
+  SendResult admit(Lane lane) {
+    if (high_watermark_ == 0 || lane == Lane::CONTROL ||
+        (!over_high_.load(std::memory_order_relaxed) &&
+         queued_.load(std::memory_order_relaxed) < high_watermark_)) {
+      count_queued(lane, 1);
+      return SendResult::OK;
+    }
+    bool first = !over_high_.exchange(true, std::memory_order_relaxed);
+    switch (policy_) {
+    case BackpressurePolicy::DROP_OLDEST:
+      // 超出高水位的部分由 strand 上的 trim_oldest 丢弃；仍在高水位以内
+      // （背压尚未降到低水位）时不会挤掉任何消息。与写出并发时为近似判断
+      return count_queued(lane, 1) > high_watermark_ ? SendResult::DROPPED_OLDEST
+                                                      : SendResult::OK;
+    case BackpressurePolicy::DROP_NEWEST:
+      stat_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return SendResult::DROPPED;
+    case BackpressurePolicy::REJECT:
+      stat_rejected_.fetch_add(1, std::memory_order_relaxed);
+      return SendResult::REJECTED;
+    case BackpressurePolicy::DISCONNECT:
+      if (first) {
+        LOG_WARN("[{}] Queue above high watermark ({}), disconnecting",
+                 conn_key_, high_watermark_);
+        close(true);
+      }
+      return SendResult::DISCONNECTED;
+    }
+    return SendResult::REJECTED;
+  }
+
+  // 返回计入后的队列深度
+  std::size_t count_queued(Lane lane, std::size_t n) {
+    lane_queued_[static_cast<std::size_t>(lane)].fetch_add(n, std::memory_order_relaxed);
+    return queued_.fetch_add(n, std::memory_order_relaxed) + n;
+  }
+
+  // 与事件队列相同，只在收件箱“空 -> 非空”时 post 一次；
+  // 收件箱是一对交替使用的 vector，容量稳定后入队不分配
+  void to_inbox(OutMsg msg, NewRequest *req) {
+    bool first;
+    {
+      std::lock_guard<std::mutex> lock(inbox_mtx_);
+      first = inbox_.empty();
+      inbox_.push_back(std::move(msg));
+      if (req)
+        inbox_requests_.push_back(std::move(*req));
+    }
+    if (first) {
+      auto self = shared_from_this();
+      boost::asio::post(strand_, make_alloc_handler(post_mem_, [this, self]() {
+        drain_inbox();
+      }));
+    }
+  }
+
+  void drain_inbox() {
+    {
+      std::lock_guard<std::mutex> lock(inbox_mtx_);
+      inbox_.swap(inbox_drain_);
+      inbox_requests_.swap(requests_drain_);
+    }
+    // 请求与其消息同序到达：入队前先登记，登记失败（已断开或 id 重复）的消息不发出
+    std::size_t ri = 0;
+    for (auto &m : inbox_drain_) {
+      if ((m.req && !register_request(std::move(requests_drain_[ri++]))) || dead_) {
+        if (dead_)
+          keep_on_disk(m);
+        uncount_queued(m.lane, 1);
+        continue;
+      }
+      lanes_[static_cast<std::size_t>(m.lane)].push_back(std::move(m));
+    }
+    inbox_drain_.clear();
+    requests_drain_.clear();
+    if (dead_)
+      return;
+    trim_oldest();
+    do_write();
+  }
+
+  // ---- 请求登记与完成，仅在 strand 上调用 ----
+  bool register_request(NewRequest &&r) {
+    if (dead_) {
+      complete_request(r.cb, RequestStatus::DISCONNECTED, {});
+      return false;
+    }
+    auto res = requests_.try_emplace(r.id);
+    if (!res.second) {
+      complete_request(r.cb, RequestStatus::DUPLICATE, {});
+      return false;
+    }
+    PendingRequest &p = res.first->second;
+    p.cb = std::move(r.cb);
+    if (r.timeout.count() > 0) {
+      // 时间轮回调不在本连接 strand 上，转回 strand 再判定；只持弱引用，
+      // 截止时间不延长连接寿命
+      std::weak_ptr<Connection> wp = shared_from_this();
+      RequestId id = r.id;
+      p.timer = wheel_->schedule(r.timeout, [wp, id]() {
+        if (auto self = wp.lock())
+          boost::asio::post(self->strand_, [self, id]() {
+            self->finish_request(id, RequestStatus::TIMEOUT, {});
+          });
+      });
+    }
+    return true;
+  }
+
+  bool finish_request(RequestId id, RequestStatus st, std::string_view reply) {
+    auto it = requests_.find(id);
+    if (it == requests_.end())
+      return false;  // 已完成（超时与回复竞争时后到者落空）
+    PendingRequest p = std::move(it->second);
+    requests_.erase(it);
+    if (p.timer && st != RequestStatus::TIMEOUT)
+      wheel_->cancel(p.timer);
+    complete_request(p.cb, st, reply);
+    return true;
+  }
+
+  void complete_request(ReplyCallback &cb, RequestStatus st, std::string_view reply) {
+    outstanding_.fetch_sub(1, std::memory_order_relaxed);
+    switch (st) {
+    case RequestStatus::OK:
+      stat_req_completed_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    case RequestStatus::TIMEOUT:
+      stat_req_timeout_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    default:
+      stat_req_failed_.fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+    if (cb)
+      cb(st, reply);
+  }
+
+  // 断开：所有未完成的请求（含尚未写出的）以 DISCONNECTED 结束
+  void fail_requests() {
+    auto all = std::move(requests_);
+    requests_.clear();
+    for (auto &kv : all) {
+      if (kv.second.timer)
+        wheel_->cancel(kv.second.timer);
+      complete_request(kv.second.cb, RequestStatus::DISCONNECTED, {});
+    }
+  }
+
+  // ---- 磁盘溢出 ----
+  // 磁盘上已有积压时新消息也写入磁盘，保证补发顺序；否则只在达到高水位时写入
+  bool should_spill(Lane lane) const {
+    if (!spill_ || lane == Lane::CONTROL)
+      return false;
+    return !spill_->empty() ||
+           (high_watermark_ != 0 &&
+            (over_high_.load(std::memory_order_relaxed) ||
+             queued_.load(std::memory_order_relaxed) >= high_watermark_));
+  }
+
+  SendResult spill_message(const Message &msg, Lane lane) {
+    bool was_empty = false;
+    if (!spill_->append(static_cast<uint8_t>(lane), msg.data(), msg.size(), &was_empty)) {
+      stat_rejected_.fetch_add(1, std::memory_order_relaxed);
+      return SendResult::REJECTED;
+    }
+    if (was_empty)
+      resume_spill();
+    return SendResult::SPILLED;
+  }
+
+  void keep_on_disk(const OutMsg &m) {
+    if (spill_ && !m.req && m.lane != Lane::CONTROL)
+      spill_->append(static_cast<uint8_t>(m.lane), m.data->data(), m.data->size());
+  }
+
+  // 断开时（strand 上）把已写出未获应答的、尚未写出的非请求消息与未下发事件
+  // 按此先后写入磁盘，交给下一代连接补发；此时磁盘上若已有积压，这部分较旧的消息会排在积压之后
+  void spill_pending() {
+    if (!spill_)
+      return;
+    for (const auto &a : awaiting_)
+      keep_on_disk(OutMsg{a.data, a.req, a.lane});
+    for (auto &q : lanes_)
+      for (const auto &m : q)
+        keep_on_disk(m);
+    event_msgs_.drain([this](EventMsg &&ev) {
+      keep_on_disk(OutMsg{std::move(ev.data)});
+    });
+    std::lock_guard<std::mutex> lock(conflate_mtx_);
+    for (const auto &e : conflate_pending_)
+      keep_on_disk(OutMsg{e.data});
+  }
+
+  // 在 strand 上：NORMAL 通道剩余不足一个窗口（且不足一批）时整批取走待合并的事件，
+  // 此后它们不再被覆盖；已移入通道的旧值至多一个窗口
+  void pull_conflated() {
+    MessageQueue &q = lanes_[static_cast<std::size_t>(Lane::NORMAL)];
+    if (conflate_size_.load(std::memory_order_relaxed) == 0 ||
+        q.size() >= std::min(max_batch_msgs_, window_))
+      return;
+    {
+      std::lock_guard<std::mutex> lock(conflate_mtx_);
+      conflate_pending_.swap(conflate_drain_);
+      conflate_index_.clear();
+      conflate_size_.store(0, std::memory_order_relaxed);
+    }
+    for (auto &e : conflate_drain_) {
+      LOG_INFO("[{}] [EVENT] {}", conn_key_, body_view(*e.data));
+      q.push_back(OutMsg{std::move(e.data)});
+    }
+    conflate_drain_.clear();
+  }
+
+  // 在 strand 上：队列回落到低水位以下时从磁盘成批取回，至多补到高水位
+  void refill_from_spill() {
+    if (!spill_ || dead_ || spill_->empty())
+      return;
+    std::size_t depth = queued_.load(std::memory_order_relaxed);
+    if (depth > low_watermark_)
+      return;
+    std::size_t room = high_watermark_ ? high_watermark_ - depth : kSpillBatch;
+    spill_->read(std::min(room, kSpillBatch), kSpillBatchBytes,
+                 [this](uint8_t tag, const uint8_t *data, std::size_t len) {
+                   Lane lane = static_cast<Lane>(tag);
+                   count_queued(lane, 1);
+                   lanes_[tag].push_back(
+                       OutMsg{make_shared_message(Message(data, data + len)), 0, lane});
+                 });
+  }
+
+  // DROP_OLDEST：超出高水位的部分从最低优先级的非空通道队首（最旧的未发送消息）
+  // 丢弃，CONTROL 通道不丢
+  void trim_oldest() {
+    if (policy_ != BackpressurePolicy::DROP_OLDEST || high_watermark_ == 0)
+      return;
+    while (queued_.load(std::memory_order_relaxed) > high_watermark_) {
+      Lane lane = Lane::BULK;
+      if (lanes_[static_cast<std::size_t>(lane)].empty())
+        lane = Lane::NORMAL;
+      MessageQueue &q = lanes_[static_cast<std::size_t>(lane)];
+      if (q.empty())
+        break;
+      if (RequestId req = q.front().req)
+        finish_request(req, RequestStatus::DROPPED, {});
+      q.pop_front();
+      uncount_queued(lane, 1);
+      stat_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void uncount_queued(Lane lane, std::size_t n) {
+    queued_.fetch_sub(n, std::memory_order_relaxed);
+    lane_queued_[static_cast<std::size_t>(lane)].fetch_sub(n, std::memory_order_relaxed);
+  }
+
+  // 消息离开待发送队列：写出到低水位以下时解除背压
+  void on_dequeued(Lane lane) {
+    std::size_t depth = queued_.fetch_sub(1, std::memory_order_relaxed) - 1;
+    lane_queued_[static_cast<std::size_t>(lane)].fetch_sub(1, std::memory_order_relaxed);
+    if (over_high_.load(std::memory_order_relaxed) && depth <= low_watermark_)
+      over_high_.store(false, std::memory_order_relaxed);
+  }
+
+  // 下一条该写的消息所在通道，全部为空时返回 nullptr
+  MessageQueue *next_lane() {
+    if (lane_scheduling_ == LaneScheduling::WEIGHTED) {
+      // 按条数的加权轮转：每轮各通道至多取 lane_weights 条，
+      // 所有非空通道的额度都用完后开始新一轮
+      for (int round = 0; round < 2; ++round) {
+        for (std::size_t i = 0; i < kLaneCount; ++i)
+          if (!lanes_[i].empty() && lane_credit_[i] > 0) {
+            --lane_credit_[i];
+            return &lanes_[i];
+          }
+        lane_credit_ = lane_weights_;
+      }
+      return nullptr;
+    }
+    for (auto &q : lanes_)
+      if (!q.empty())
+        return &q;
+    return nullptr;
+  }
+
+  // 整批摘下事件，直接移入发送队列交给写循环（与普通消息共用聚合写）
+  void flush_events() {
+    event_msgs_.drain([this](EventMsg &&ev) {
+      LOG_INFO("[{}] [EVENT] {}", conn_key_, body_view(*ev.data));
+      lanes_[static_cast<std::size_t>(Lane::NORMAL)].push_back(OutMsg{std::move(ev.data)});
+    });
+    trim_oldest();
+    do_write();
+  }
+
+  // 按通道调度取出一批：最多 max_batch_msgs_ 条 / max_batch_bytes_ 字节且不超出窗口，
+  // 填好缓冲序列并记下发出时刻；无可写时返回 false
+  bool take_batch() {
+    if (dead_ || inflight_ >= window_)
+      return false;
+    refill_from_spill();
+    pull_conflated();
+    std::size_t limit = std::min(max_batch_msgs_, window_ - inflight_);
+    std::size_t bytes = 0;
+    auto now = std::chrono::steady_clock::now();
+    while (write_batch_.size() < limit) {
+      MessageQueue *q = next_lane();
+      if (!q)
+        break;
+      OutMsg &m = q->front();
+      std::size_t len = m.data->size();
+      if (!write_batch_.empty() && bytes + len > max_batch_bytes_) {
+        if (lane_scheduling_ == LaneScheduling::WEIGHTED)
+          ++lane_credit_[static_cast<std::size_t>(m.lane)];  // 未取出，退回额度
+        break;
+      }
+      bytes += len;
+      awaiting_.push_back(Awaiting{now, m.req, m.data, m.lane});
+      write_batch_.push_back(std::move(m.data));
+      on_dequeued(m.lane);
+      q->pop_front();
+    }
+    if (write_batch_.empty())
+      return false;
+    write_bufs_.clear();
+    for (const auto &m : write_batch_)
+      write_bufs_.push_back(boost::asio::buffer(*m));
+    return true;
+  }
+
+  BufferSpan batch_buffers() const {
+    return BufferSpan{write_bufs_.data(), write_bufs_.data() + write_bufs_.size()};
+  }
+
+  // 一批写完：记账，整批转为在途
+  void finish_batch(std::size_t bytes) {
+    uint64_t count = write_batch_.size();
+    record_batch(count, bytes);
+    write_batch_.clear();
+    inflight_ += count;
+  }
+
+  // 写循环：窗口未满且有待发消息时继续写，不等回复（PING_PONG 时窗口为 1）。
+  // 每批以一个缓冲序列交给 async_write（底层为 writev），减少系统调用和回调次数。
+  // 协程引擎下只唤醒常驻的写协程
+  void do_write() {
+#ifdef CLIENT_HAS_COROUTINES
+    if (coroutine_) {
+      write_ready_.notify();
+      return;
+    }
+#endif
+    if (writing_ || !take_batch())
+      return;
+    writing_ = true;
+
+    auto self = shared_from_this();
+    boost::asio::async_write(
+        socket_, batch_buffers(),
+        boost::asio::bind_executor(
+            strand_, make_alloc_handler(write_mem_, [this, self](
+                                                        boost::system::error_code ec,
+                                                        std::size_t n) {
+              if (dead_)
+                return;
+              writing_ = false;
+              if (!ec) {
+                finish_batch(n);
+                do_read();
+                do_write();
+              } else {
+                handle_disconnect("Write error", ec, true);
+              }
+            })));
+  }
+
+  // 读循环：只要还有未回复的消息就持续读，每收到一行回复释放一个窗口。
+  // 直接读入分帧器的复用缓冲区，一次读到的多行回复全部就地处理
+  void do_read() {
+#ifdef CLIENT_HAS_COROUTINES
+    if (coroutine_) {
+      read_ready_.notify();
+      return;
+    }
+#endif
+    if (reading_ || dead_ || inflight_ == 0)
+      return;
+    auto space = framer_.prepare();
+    if (space.second == 0) {
+      handle_disconnect("Reply line too long",
+                        boost::asio::error::message_size, true);
+      return;
+    }
+    reading_ = true;
+    auto self = shared_from_this();
+    socket_.async_read_some(
+        boost::asio::buffer(space.first, space.second),
+        boost::asio::bind_executor(
+            strand_, make_alloc_handler(read_mem_, [this, self](
+                                                       boost::system::error_code ec,
+                                                       std::size_t n) {
+              if (dead_)
+                return;
+              reading_ = false;
+              if (!ec) {
+                framer_.commit(n, [this](std::string_view line) {
+                  on_reply(line);
+                });
+                do_read();
+                do_write();
+              } else {
+                handle_disconnect("Read error", ec, true);
+              }
+            })));
+  }
+
+#ifdef CLIENT_HAS_COROUTINES
+  // 协程引擎：读、写各一个常驻协程，状态就是协程里的执行位置，
+  // 不再需要 writing_ / reading_。IO 在途时帧内的 self 保活连接，每次读写
+  // 不再拷贝 shared_ptr；无事可做时挂起在 CoSignal 上并放开 self，
+  // 连接析构时一并销毁挂起的帧
+  CoTask write_loop() {
+    Ptr self = shared_from_this();
+    for (;;) {
+      if (dead_)
+        co_return;
+      if (!take_batch()) {
+        co_await write_ready_.wait(std::move(self));
+        if (dead_)
+          co_return;
+        self = shared_from_this();
+        continue;
+      }
+      IoResult r = co_await async_io([this](auto handler) {
+        boost::asio::async_write(
+            socket_, batch_buffers(),
+            boost::asio::bind_executor(
+                strand_, make_alloc_handler(write_mem_, std::move(handler))));
+      });
+      if (dead_)
+        co_return;
+      if (r.ec) {
+        handle_disconnect("Write error", r.ec, true);
+        co_return;
+      }
+      finish_batch(r.bytes);
+      read_ready_.notify();
+    }
+  }
+
+  CoTask read_loop() {
+    Ptr self = shared_from_this();
+    for (;;) {
+      if (dead_)
+        co_return;
+      if (inflight_ == 0) {
+        co_await read_ready_.wait(std::move(self));
+        if (dead_)
+          co_return;
+        self = shared_from_this();
+        continue;
+      }
+      auto space = framer_.prepare();
+      if (space.second == 0) {
+        handle_disconnect("Reply line too long",
+                          boost::asio::error::message_size, true);
+        co_return;
+      }
+      IoResult r = co_await async_io([this, space](auto handler) {
+        socket_.async_read_some(
+            boost::asio::buffer(space.first, space.second),
+            boost::asio::bind_executor(
+                strand_, make_alloc_handler(read_mem_, std::move(handler))));
+      });
+      if (dead_)
+        co_return;
+      if (r.ec) {
+        handle_disconnect("Read error", r.ec, true);
+        co_return;
+      }
+      framer_.commit(r.bytes, [this](std::string_view line) { on_reply(line); });
+      write_ready_.notify();
+    }
+  }
+#endif
+
+  // 断开时让挂起的循环协程醒来退出
+  void wake_loops() {
+#ifdef CLIENT_HAS_COROUTINES
+    write_ready_.notify();
+    read_ready_.notify();
+#endif
+  }
+
+  void on_reply(std::string_view line) {
+    LOG_INFO("[{}] [RECV] {}", conn_key_, line);
+    if (inflight_ > 0)
+      --inflight_;
+    // 设备按序应答：队首即本行回复对应的那条消息
+    RequestId req = 0;
+    if (!awaiting_.empty()) {
+      auto rtt = std::chrono::steady_clock::now() - awaiting_.front().sent;
+      req = awaiting_.front().req;
+      awaiting_.pop_front();
+      uint64_t us = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(rtt).count());
+      rtt_.record(us);
+      // 权重 1/8 的指数平滑，只有 strand 写入
+      uint64_t prev = rtt_ewma_us_.load(std::memory_order_relaxed);
+      rtt_ewma_us_.store(prev ? prev - prev / 8 + us / 8 : std::max<uint64_t>(us, 1),
+                         std::memory_order_relaxed);
+    }
+    if (correlate_ && !correlate_(line, req))
+      req = 0;
+    if (req)
+      finish_request(req, RequestStatus::OK, line);
+  }
+
+  void record_batch(uint64_t count, std::size_t bytes) {
+    stat_batches_.fetch_add(1, std::memory_order_relaxed);
+    stat_messages_.fetch_add(count, std::memory_order_relaxed);
+    stat_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    if (count > stat_max_batch_.load(std::memory_order_relaxed))
+      stat_max_batch_.store(count, std::memory_order_relaxed);
+  }
+
+  void handle_disconnect(const char *what, const boost::system::error_code &ec,
+                         bool need_reconnect) {
+    if (dead_)
+      return;
+    dead_ = true;
+    closed_.store(true, std::memory_order_relaxed);
+    LOG_ERROR("[{}] {}: {}", conn_key_, what, ec.message());
+    boost::system::error_code ignore_ec;
+    socket_.close(ignore_ec);
+    wake_loops();
+    spill_pending();
+    fail_requests();
+    if (on_disconnect_)
+      on_disconnect_(this, need_reconnect);
+  }
+
+  boost::asio::ip::tcp::socket socket_;
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+  std::array<MessageQueue, kLaneCount> lanes_;  // 各通道待发送消息，下标为 Lane
+  std::mutex inbox_mtx_;
+  std::vector<OutMsg> inbox_;        // 生产者写入，受 inbox_mtx_ 保护
+  std::vector<OutMsg> inbox_drain_;  // strand 上与 inbox_ 交换后取出
+  std::vector<NewRequest> inbox_requests_;  // 随 inbox_ 到达的请求，受 inbox_mtx_ 保护
+  std::vector<NewRequest> requests_drain_;
+  std::unordered_map<RequestId, PendingRequest> requests_;  // 未完成的请求，仅在 strand 上访问
+  std::vector<SharedMessage> write_batch_;           // 正在写的一批消息
+  std::vector<boost::asio::const_buffer> write_bufs_;  // 复用的缓冲序列
+  // 完成回调的复用内存：读、写各至多一个在途；post 只在收件箱/事件队列
+  // 由空变非空时发生，外加攒批定时器，同时在途的很少
+  HandlerMemory<2, 1024> write_mem_;  // 写操作对象含缓冲序列状态，约 550 字节
+  HandlerMemory<2> read_mem_;
+  HandlerMemory<4> post_mem_;
+  LineFramer framer_;
+  RingQueue<Awaiting> awaiting_;  // 已写出、等待回复的消息
+  LatencyHistogram rtt_;
+  std::atomic<uint64_t> rtt_ewma_us_{0};  // 平滑往返时延，0 表示尚无样本
+  bool writing_;                      // 有 async_write 在途
+  bool reading_;                      // 有 async_read_until 在途
+  bool dead_;
+  std::atomic<bool> closed_{false};   // 与 dead_ 同时置位，供生产者线程判断
+  bool started_ = false;              // 已建连
+  std::size_t inflight_;              // 已写出、尚未收到回复的消息数
+  std::size_t window_;                // 允许的最大 inflight_
+  std::size_t max_batch_msgs_;
+  std::size_t max_batch_bytes_;
+  std::string conn_key_;
+  WriteMode write_mode_;
+  MpscQueue<EventMsg> event_msgs_;    // 本连接的事件队列，多生产者/strand 单消费者
+  std::mutex conflate_mtx_;
+  std::vector<ConflatedEvent> conflate_pending_;  // 待合并事件，按首次到达顺序，受 conflate_mtx_ 保护
+  std::unordered_map<uint64_t, std::size_t> conflate_index_;  // (类型, key) 哈希 -> 下标
+  std::vector<ConflatedEvent> conflate_drain_;  // strand 上与 conflate_pending_ 交换后取出
+  std::atomic<std::size_t> conflate_size_{0};
+  std::atomic<uint64_t> stat_conflated_{0};
+  TimingWheel::Ptr wheel_;
+  TimingWheel::TimerId event_timer_id_ = 0;  // 攒批定时器，仅在 strand 上访问
+  std::chrono::milliseconds event_batch_delay_;
+  std::size_t event_batch_max_;
+  std::size_t high_watermark_;
+  std::size_t low_watermark_;
+  BackpressurePolicy policy_;
+  std::atomic<std::size_t> queued_{0};   // 待发送消息数（含未下发事件）
+  std::array<std::atomic<std::size_t>, kLaneCount> lane_queued_{};  // queued_ 按通道分
+  std::atomic<bool> over_high_{false};   // 背压中
+  std::atomic<uint64_t> stat_dropped_{0};
+  std::atomic<uint64_t> stat_rejected_{0};
+  IoContextPool::Lease lease_;        // 每核模式下占用的 io_context 名额
+  DisconnectCallback on_disconnect_;
+  std::atomic<uint64_t> stat_batches_{0};
+  std::atomic<uint64_t> stat_messages_{0};
+  std::atomic<uint64_t> stat_bytes_{0};
+  std::atomic<uint64_t> stat_max_batch_{0};
+  CorrelationFn correlate_;
+  std::atomic<RequestId> next_request_id_{0};
+  std::atomic<std::size_t> outstanding_{0};
+  std::atomic<uint64_t> stat_req_completed_{0};
+  std::atomic<uint64_t> stat_req_timeout_{0};
+  std::atomic<uint64_t> stat_req_failed_{0};
+  static constexpr std::size_t kSpillBatch = 256;  // 单次从磁盘取回的条数上限
+  static constexpr std::size_t kSpillBatchBytes = 1 << 20;
+  std::shared_ptr<SpillStore> spill_;
+  LaneScheduling lane_scheduling_;
+  std::array<unsigned, kLaneCount> lane_weights_;
+  std::array<unsigned, kLaneCount> lane_credit_{};  // WEIGHTED 本轮剩余额度，仅在 strand 上访问
+  bool coroutine_ = false;  // 使用协程引擎
+  // 在 SubscriptionIndex 各类型成员表中的下标，下标为 EventType；只经成员表读写
+  std::array<std::size_t, kEventTypeCount> sub_pos_;
+  // 所在端点组（GroupHandle::id，0 为不在组内）及在其成员表中的下标；只在组索引的锁内访问
+  uint32_t group_id_ = 0;
+  std::size_t group_pos_ = kNotListed;
+#ifdef CLIENT_HAS_COROUTINES
+  CoSignal write_ready_;  // 写协程等待：队列非空且窗口有余
+  CoSignal read_ready_;   // 读协程等待：有在途消息
+#endif
+};
+
+// ============ SubscriptionIndex =============
+// EventType -> 订阅连接列表，每个类型一张 MemberList，连接在各表中的下标存于 sub_pos_。
+// 刚移除的连接仍可能在他人持有的旧快照里收到事件，由连接自身判断已断开后丢弃
+class SubscriptionIndex {
+public:
+  using List = MemberList<Connection>::List;
+  using ListPtr = MemberList<Connection>::ListPtr;
+
+  void add(EventType type, const Connection::Ptr &conn) {
+    std::size_t i = static_cast<std::size_t>(type);
+    tables_[i].add(conn, conn->sub_pos_[i]);
+  }
+
+  void remove(EventType type, const Connection::Ptr &conn) {
+    std::size_t i = static_cast<std::size_t>(type);
+    tables_[i].remove(conn->sub_pos_[i]);
+  }
+
+  // 连接断开时从所有类型中移除
+  void remove_all(const Connection::Ptr &conn) {
+    for (std::size_t i = 0; i < kEventTypeCount; ++i)
+      tables_[i].remove(conn->sub_pos_[i]);
+  }
+
+  // 没有订阅者时返回空
+  ListPtr subscribers(EventType type) const {
+    return tables_[static_cast<std::size_t>(type)].snapshot();
+  }
+
+private:
+  std::array<MemberList<Connection>, kEventTypeCount> tables_;  // 下标为 EventType
+};
+
+// ============ GroupIndex =============
+// 端点组 -> 在线成员列表，每组一张 MemberList，连接记住所在组与下标（group_id_ / group_pos_）。
+// 连接建立时加入、断开时移除，所以成员一断开，下一次发送就只在其余成员中选择。
+// 组一经创建不删除（成员全部离开后为空组），句柄因此长期有效
+struct GroupHandle {
+  uint32_t id = 0;  // 组下标 + 1，0 表示无效
+  bool valid() const { return id != 0; }
+};
+
+struct GroupStats {
+  std::size_t online = 0;  // 在线成员数
+  uint64_t sent = 0;       // 被某个成员接收的消息
+  uint64_t rerouted = 0;   // 首选成员拒收或已断开，改投其他成员的次数
+  uint64_t failed = 0;     // 没有成员接收
+};
+
+class GroupIndex {
+public:
+  using List = MemberList<Connection>::List;
+  using ListPtr = MemberList<Connection>::ListPtr;
+
+private:
+  struct Group {
+    MemberList<Connection> members;
+    GroupRouting routing = GroupRouting::QUEUE_DEPTH;
+    mutable std::atomic<uint32_t> cursor{0};
+    mutable std::atomic<uint64_t> sent{0};
+    mutable std::atomic<uint64_t> rerouted{0};
+    mutable std::atomic<uint64_t> failed{0};
+  };
+
+public:
+  // 路由时一次取出的组快照；start 由组内游标递增得到，负载相同时轮转首选成员。
+  // 组对象不删除，计数可在锁外更新
+  struct View {
+    ListPtr members;
+    GroupRouting routing = GroupRouting::QUEUE_DEPTH;
+    uint32_t start = 0;
+    const Group *group = nullptr;
+
+    void record(bool sent, bool rerouted) const {
+      (sent ? group->sent : group->failed).fetch_add(1, std::memory_order_relaxed);
+      if (rerouted)
+        group->rerouted.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+
+  GroupHandle find(const std::string &name) const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    auto it = ids_.find(name);
+    return it == ids_.end() ? GroupHandle{} : GroupHandle{it->second + 1};
+  }
+
+  // 加入组，组不存在时创建；routing 覆盖组原有设置。已在其他组时先离开原组
+  GroupHandle add(const std::string &name, GroupRouting routing,
+                  const Connection::Ptr &conn) {
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    auto res = ids_.emplace(name, static_cast<uint32_t>(groups_.size()));
+    if (res.second)
+      groups_.emplace_back(new Group());
+    uint32_t id = res.first->second + 1;
+    Group &g = *groups_[id - 1];
+    g.routing = routing;
+    if (conn->group_id_ != id) {
+      erase(*conn);
+      conn->group_id_ = id;
+      g.members.add(conn, conn->group_pos_);
+    }
+    return GroupHandle{id};
+  }
+
+  // 连接断开或改组时从所在组移除
+  void remove(const Connection::Ptr &conn) {
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    erase(*conn);
+  }
+
+  bool view(GroupHandle h, View &out) const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    const Group *g = group(h);
+    if (!g)
+      return false;
+    out.members = g->members.snapshot();
+    out.routing = g->routing;
+    out.start = g->cursor.fetch_add(1, std::memory_order_relaxed);
+    out.group = g;
+    return true;
+  }
+
+  bool stats(GroupHandle h, GroupStats &out) const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    const Group *g = group(h);
+    if (!g)
+      return false;
+    out.online = g->members.size();
+    out.sent = g->sent.load(std::memory_order_relaxed);
+    out.rerouted = g->rerouted.load(std::memory_order_relaxed);
+    out.failed = g->failed.load(std::memory_order_relaxed);
+    return true;
+  }
+
+private:
+  // 需持有 mtx_
+  const Group *group(GroupHandle h) const {
+    return h.valid() && h.id <= groups_.size() ? groups_[h.id - 1].get() : nullptr;
+  }
+
+  // 需持有写锁
+  void erase(Connection &conn) {
+    if (conn.group_id_ == 0)
+      return;
+    groups_[conn.group_id_ - 1]->members.remove(conn.group_pos_);
+    conn.group_id_ = 0;
+  }
+
+  mutable std::shared_mutex mtx_;  // 保护 groups_、ids_ 与各连接的 group_id_；先于成员表加锁
+  std::vector<std::unique_ptr<Group>> groups_;
+  std::unordered_map<std::string, uint32_t> ids_;
+};
+
+// ============ ClientManager =============
+// 连接句柄：每个配置端点一个，重连期间保持不变，从配置中删除后失效
+using ConnHandle = SlotHandle;
+
+class ClientManager : public std::enable_shared_from_this<ClientManager> {
+public:
+  using ConnectionPtr = Connection::Ptr;
+
+  ClientManager(boost::asio::io_context &io)
+      : io_context_(io), wheel_(TimingWheel::create(io)),
+        connect_limiter_(policy_.max_concurrent_connects) {}
+
+  // 每核模式：连接按最少负载分布到 pool 的各 io_context，
+  // 管理器自身的时间轮运行在第 0 个 io_context 上
+  explicit ClientManager(IoContextPool &pool)
+      : io_context_(pool.context(0)), wheel_(TimingWheel::create(pool.context(0))), pool_(&pool),
+        connect_limiter_(policy_.max_concurrent_connects) {}
+
+  // 析构即关停：静默关闭所有在线连接，未完成的请求（含尚未写出的）在各连接
+  // strand 上以 DISCONNECTED 结束。连接由在途读写保活，可能比管理器活得久，
+  // 关闭后迟到的回复不再处理；正在建连的在完成时发现管理器已不在，自行关闭
+  ~ClientManager() {
+    connections_.for_each(
+        [](ConnHandle, const ConnectionPtr &c) { c->close(false, false); });
+  }
+
+  void set_reconnect_policy(const ReconnectPolicy &policy) {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      policy_ = policy;
+    }
+    connect_limiter_.set_limit(policy.max_concurrent_connects);
+  }
+
+  // 建连指标：在途/排队/累计成功失败/退避等待数
+  ConnectStats connect_stats() const {
+    ConnectStats st = connect_limiter_.stats();
+    st.retry_waiting = retry_waiting_.load(std::memory_order_relaxed);
+    return st;
+  }
+
+  // 新增：支持事件类型
+  ConnHandle add_connection(const std::string &ip, uint16_t port,
+                            bool auto_reconnect = true,
+                            EventType type = EventType::EVENT_A) {
+    ConnInfo info;
+    info.ip = ip;
+    info.port = port;
+    info.auto_reconnect = auto_reconnect;
+    info.event_types = {type};
+    return add_connection(info);
+  }
+
+  // 完整参数版本（可指定写模式、流水线窗口等）
+  // 返回端点句柄，发送与查询优先用句柄，省去按 "ip:port" 查找
+  ConnHandle add_connection(const ConnInfo &info) {
+    std::string key = make_key(info);
+    ConnHandle h;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto it = handles_.find(key);
+      if (it != handles_.end()) {
+        h = it->second;
+      } else {
+        h = connections_.allocate();
+        handles_.emplace(key, h);
+        if (endpoints_.size() <= h.index)
+          endpoints_.resize(h.index + 1);
+      }
+      Endpoint &ep = endpoints_[h.index];
+      ep.handle = h;
+      ep.key = std::move(key);
+      ep.info = info;
+      if (!info.spill_dir.empty() && !ep.spill) {
+        ep.spill = std::make_shared<SpillStore>(info.spill_dir, ep.key,
+                                                info.spill_segment_bytes,
+                                                info.spill_max_bytes);
+        ep.offline = std::make_shared<OfflineSpill>(h, ep.spill);
+      }
+      sync_offline(ep);
+    }
+    do_connect(h);
+    return h;
+  }
+
+  // "ip:port" -> 句柄，不存在时返回无效句柄
+  ConnHandle find_handle(const std::string &key) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = handles_.find(key);
+    return it == handles_.end() ? ConnHandle{} : it->second;
+  }
+
+  void close_connection(ConnHandle h) {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (Endpoint *ep = endpoint(h))
+        ep->info.auto_reconnect = false;
+    }
+    connections_.visit(h, [](const ConnectionPtr &c) { c->close(false); });
+  }
+
+  void close_connection(const std::string &key) {
+    close_connection(find_handle(key));
+  }
+
+  // 热路径：一次数组下标 + 代数比较，只锁该连接的槽位
+  // 返回值反映背压状态（见 is_backpressure），生产者据此降速；
+  // lane 决定在该连接上的发送优先级，见 Lane
+  SendResult send_message(ConnHandle h, SharedMessage msg,
+                          Lane lane = Lane::NORMAL) {
+    // 取出连接后在槽锁外入队：入队可能写磁盘（见 SpillStore），不能占着槽自旋锁；
+    // 连接刚关闭、尚未摘除时同离线处理
+    ConnectionPtr c;
+    SendResult r = SendResult::NO_CONNECTION;
+    if (connections_.find(h, c))
+      r = c->push_message(msg, lane);
+    return r == SendResult::NO_CONNECTION ? spill_offline(h, *msg, lane) : r;
+  }
+
+  SendResult send_message(ConnHandle h, const Connection::Message &msg,
+                          Lane lane = Lane::NORMAL) {
+    return send_message(h, make_shared_message(msg), lane);
+  }
+
+  // 按 key 发送需先查索引，频繁发送的调用方应缓存句柄
+  SendResult send_message(const std::string &key, SharedMessage msg,
+                          Lane lane = Lane::NORMAL) {
+    return send_message(find_handle(key), std::move(msg), lane);
+  }
+
+  SendResult send_message(const std::string &key,
+                          const Connection::Message &msg,
+                          Lane lane = Lane::NORMAL) {
+    return send_message(find_handle(key), make_shared_message(msg), lane);
+  }
+
+  // "group" -> 组句柄，组尚未有成员建连过时返回无效句柄
+  GroupHandle find_group(const std::string &name) const {
+    return groups_.find(name);
+  }
+
+  // 发给组内负载最轻的在线成员（见 GroupRouting），处于背压（含正在写磁盘）的成员排在最后；
+  // 选中的成员拒收或恰好断开时依次改投下一个，写入成员溢出队列（SPILLED）算作接收，
+  // 返回最后一次入队结果。
+  // 成员断开时其未发出的消息随连接丢弃，之后的发送立即只在其余成员间分配
+  SendResult send_to_group(GroupHandle g, SharedMessage msg,
+                           Lane lane = Lane::NORMAL) {
+    GroupIndex::View v;
+    if (!groups_.view(g, v))
+      return SendResult::NO_CONNECTION;
+    if (!v.members || v.members->empty()) {
+      v.record(false, false);
+      return SendResult::NO_CONNECTION;
+    }
+    const auto &members = *v.members;
+    std::size_t n = members.size();
+    // (负载, 相对首选位置的偏移)，负载相同时按轮转顺序
+    thread_local std::vector<std::pair<uint64_t, std::size_t>> order;
+    order.clear();
+    for (std::size_t i = 0; i < n; ++i) {
+      const ConnectionPtr &c = members[(v.start + i) % n];
+      uint64_t load = c->queue_depth();
+      if (v.routing == GroupRouting::RTT)
+        load = (load + 1) * c->rtt_estimate_us();
+      if (c->backpressured())
+        load |= uint64_t(1) << 63;
+      order.emplace_back(load, i);
+    }
+    std::sort(order.begin(), order.end());
+    SendResult r = SendResult::NO_CONNECTION;
+    for (std::size_t k = 0; k < n; ++k) {
+      r = members[(v.start + order[k].second) % n]->push_message(msg, lane);
+      // SPILLED 已写入该成员的溢出队列，之后补发，不能再投给别人
+      if (r == SendResult::OK || r == SendResult::DROPPED_OLDEST ||
+          r == SendResult::SPILLED) {
+        v.record(true, k > 0);
+        return r;
+      }
+    }
+    v.record(false, n > 1);
+    return r;
+  }
+
+  SendResult send_to_group(const std::string &group, SharedMessage msg,
+                           Lane lane = Lane::NORMAL) {
+    return send_to_group(find_group(group), std::move(msg), lane);
+  }
+
+  bool group_stats(GroupHandle g, GroupStats &out) const {
+    return groups_.stats(g, out);
+  }
+
+  // 异步请求：回复、超时或失败时在该连接的 strand 上回调 cb，见 RequestTicket。
+  // 默认按发送顺序对应回复，ConnInfo::correlate 非空时按 id 对应
+  RequestTicket request(ConnHandle h, SharedMessage msg,
+                        std::chrono::milliseconds timeout, ReplyCallback cb,
+                        Lane lane = Lane::NORMAL) {
+    // 与 send_message 相同在槽锁外入队：入队会调用用户的 correlate 并加收件箱锁
+    ConnectionPtr c;
+    if (!connections_.find(h, c))
+      return RequestTicket();
+    return c->push_request(std::move(msg), timeout, std::move(cb), lane);
+  }
+
+  RequestTicket request(const std::string &key, SharedMessage msg,
+                        std::chrono::milliseconds timeout, ReplyCallback cb,
+                        Lane lane = Lane::NORMAL) {
+    return request(find_handle(key), std::move(msg), timeout, std::move(cb), lane);
+  }
+
+  // 以 CANCELLED 结束请求；连接已不存在时返回 false（其请求已以 DISCONNECTED 结束）
+  bool cancel_request(ConnHandle h, RequestId id) {
+    return connections_.visit(
+        h, [id](const ConnectionPtr &c) { c->cancel_request(id); });
+  }
+
+  bool request_stats(ConnHandle h, RequestStats &out) {
+    return connections_.visit(
+        h, [&out](const ConnectionPtr &c) { out = c->request_stats(); });
+  }
+
+  // 端点的磁盘溢出统计，未启用溢出或句柄已失效时返回 false
+  bool spill_stats(ConnHandle h, SpillStats &out) {
+    std::shared_ptr<SpillStore> spill;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (Endpoint *ep = endpoint(h))
+        spill = ep->spill;
+    }
+    if (!spill)
+      return false;
+    out = spill->stats();
+    return true;
+  }
+
+  bool queue_stats(ConnHandle h, QueueStats &out) {
+    return connections_.visit(
+        h, [&out](const ConnectionPtr &c) { out = c->queue_stats(); });
+  }
+
+  bool queue_stats(const std::string &key, QueueStats &out) {
+    return queue_stats(find_handle(key), out);
+  }
+
+  // 查询某连接的聚合写统计，连接不在线时返回 false
+  bool write_stats(ConnHandle h, WriteStats &out) {
+    return connections_.visit(
+        h, [&out](const ConnectionPtr &c) { out = c->write_stats(); });
+  }
+
+  bool write_stats(const std::string &key, WriteStats &out) {
+    return write_stats(find_handle(key), out);
+  }
+
+  // 查询某连接的往返时延分位数，连接不在线时返回 false
+  bool rtt_stats(ConnHandle h, LatencySummary &out) {
+    return connections_.visit(h, [&out](const ConnectionPtr &c) {
+      out = c->rtt_snapshot().summary();
+    });
+  }
+
+  bool rtt_stats(const std::string &key, LatencySummary &out) {
+    return rtt_stats(find_handle(key), out);
+  }
+
+  // 所有在线连接合并后的往返时延分位数
+  LatencySummary rtt_stats() {
+    LatencySnapshot all;
+    connections_.for_each([&all](ConnHandle, const ConnectionPtr &c) {
+      all.merge(c->rtt_snapshot());
+    });
+    return all.summary();
+  }
+
+  // 所有在线连接累计收到的回复数（断开的连接不再计入）
+  uint64_t reply_count() {
+    uint64_t n = 0;
+    connections_.for_each(
+        [&n](ConnHandle, const ConnectionPtr &c) { n += c->replies(); });
+    return n;
+  }
+
+  // 时间轮可能比管理器活得久（连接各持一份），回调只持弱引用
+  void start_send_loop() {
+    std::weak_ptr<ClientManager> wp = shared_from_this();
+    wheel_->schedule(std::chrono::seconds(1), [wp]() {
+      auto mgr = wp.lock();
+      if (!mgr)
+        return;
+      SharedMessage msg = make_msg();  // 所有连接共享同一份心跳，走控制通道
+      mgr->connections_.for_each([&msg](ConnHandle, const ConnectionPtr &c) {
+        c->push_message(msg, Lane::CONTROL);
+      });
+      mgr->start_send_loop();
+    });
+  }
+
+  // 只处理槽位中仍是 closed 的情况：连接已被重建、删除或替换时，
+  // 摘除它的一方已接管后续处理，旧连接迟到的回调不得清掉新连接或再次拨号
+  void on_connection_closed(ConnHandle h, Connection *closed, bool need_reconnect) {
+    ConnectionPtr conn;
+    if (!connections_.exchange_if(
+            h, [closed](const ConnectionPtr &cur) { return cur.get() == closed; },
+            nullptr, &conn))
+      return;
+    subscriptions_.remove_all(conn);
+    groups_.remove(conn);
+    std::string key;
+    bool reconnect;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      Endpoint *ep = endpoint(h);
+      if (!ep)
+        return;  // 已从配置中删除
+      key = ep->key;
+      reconnect = need_reconnect && ep->info.auto_reconnect;
+      if (!reconnect) {
+        drop_endpoint(h);
+      } else if (ep->offline) {
+        ep->offline->offline = true;
+        sync_offline(*ep);
+      }
+    }
+    if (reconnect) {
+      LOG_INFO("Connection lost, will retry: {}", key);
+      retry_connect_later(h, key);
+    } else {
+      LOG_INFO("Connection closed, not reconnect: {}", key);
+    }
+  }
+
+  // 热重载接口：对比新旧参数，只处理真正变化的端点：
+  // 删除的关闭、新增的建连、链路参数变化的重建、仅订阅变化的原地改订阅，
+  // 其余连接保持不动，不产生重连和消息空窗
+  ReloadStats reload_connections(const std::vector<ConnInfo> &new_params) {
+    std::map<std::string, ConnInfo> next;
+    for (const auto &info : new_params)
+      next[make_key(info)] = info;
+
+    ReloadStats st;
+    std::vector<ConnHandle> removed;
+    std::vector<ConnInfo> added, reopened;
+    std::vector<std::pair<ConnHandle, std::vector<EventType>>> old_subs;
+    std::vector<ConnHandle> regrouped;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      for (const auto &kv : handles_)
+        if (!next.count(kv.first))
+          removed.push_back(kv.second);
+      for (auto &kv : next) {
+        auto it = handles_.find(kv.first);
+        if (it == handles_.end()) {
+          added.push_back(kv.second);
+          continue;
+        }
+        ConnInfo &cur = endpoints_[it->second.index].info;
+        if (!same_link_params(cur, kv.second)) {
+          reopened.push_back(kv.second);
+        } else {
+          bool subs = cur.event_types != kv.second.event_types;
+          bool group = cur.group != kv.second.group ||
+                       cur.group_routing != kv.second.group_routing;
+          if (subs)
+            old_subs.emplace_back(it->second, cur.event_types);
+          if (group)
+            regrouped.push_back(it->second);
+          if (!subs && !group)
+            ++st.unchanged;
+          cur = kv.second;
+        }
+      }
+    }
+
+    for (ConnHandle h : removed)
+      remove_connection(h);
+    for (const auto &info : added)
+      add_connection(info);
+    for (const auto &info : reopened)
+      reopen_connection(info);
+    for (const auto &kv : old_subs) {
+      std::vector<EventType> now;
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (Endpoint *ep = endpoint(kv.first)) {
+          now = ep->info.event_types;
+          sync_offline(*ep);
+        }
+      }
+      connections_.visit(kv.first, [&](const ConnectionPtr &c) {
+        for (EventType t : kv.second)
+          if (std::find(now.begin(), now.end(), t) == now.end())
+            subscriptions_.remove(t, c);
+        for (EventType t : now)
+          subscriptions_.add(t, c);
+      });
+    }
+
+    for (ConnHandle h : regrouped) {
+      std::string group;
+      GroupRouting routing;
+      {
+        std::lock_guard<std::mutex> lock(mtx_);
+        Endpoint *ep = endpoint(h);
+        if (!ep)
+          continue;
+        group = ep->info.group;
+        routing = ep->info.group_routing;
+      }
+      connections_.visit(h, [&](const ConnectionPtr &c) {
+        groups_.remove(c);
+        if (!group.empty())
+          groups_.add(group, routing, c);
+      });
+    }
+
+    st.added = added.size();
+    st.removed = removed.size();
+    st.reopened = reopened.size();
+    st.resubscribed = old_subs.size();
+    st.regrouped = regrouped.size();
+    LOG_INFO("Reload: +{} -{} ~{} sub{} grp{} ={}", st.added, st.removed,
+             st.reopened, st.resubscribed, st.regrouped, st.unchanged);
+    return st;
+  }
+
+  // 新增：线程安全地将消息推到所有订阅该事件类型的连接，
+  // 事件按行下发给设备，到达后由各连接 strand 在毫秒级内写出
+  EventRouteResult on_redis_event(EventType type, const std::string& msg) {
+    return on_redis_event(type, make_shared_message(msg + "\n"));
+  }
+
+  // 同一份事件体被所有订阅连接共享
+  // 只遍历订阅了该类型的连接
+  // 返回各订阅者的入队结果汇总，backpressured() 为真时生产者应降速
+  EventRouteResult on_redis_event(EventType type, const SharedMessage& msg) {
+    EventRouteResult res;
+    // 先取离线端点再取订阅连接，与上线时的登记顺序相反，见 OfflineSpill
+    auto offline = offline_subs_[static_cast<std::size_t>(type)].snapshot();
+    auto subs = subscriptions_.subscribers(type);
+    if (offline)
+      spill_event(*offline, msg, res);
+    if (subs)
+      route_event(*subs, type, msg, res);
+    return res;
+  }
+
+  // 成批投递（如 RedisSubscriber 一次读到的全部推送）：连续同类型的事件只取一次
+  // 订阅列表；返回整批的汇总，subscribers 为各事件订阅者数之和
+  EventRouteResult on_redis_events(const EventBatch &batch) {
+    EventRouteResult res;
+    MemberList<OfflineSpill>::ListPtr offline;
+    SubscriptionIndex::ListPtr subs;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      if (i == 0 || batch[i].first != batch[i - 1].first) {
+        offline = offline_subs_[static_cast<std::size_t>(batch[i].first)].snapshot();
+        subs = subscriptions_.subscribers(batch[i].first);
+      }
+      if (offline)
+        spill_event(*offline, batch[i].second, res);
+      if (subs)
+        route_event(*subs, batch[i].first, batch[i].second, res);
+    }
+    return res;
+  }
+
+  // 为事件类型开启最新值合并：每个订阅连接上同 key 尚未下发的更新被新值原地覆盖，
+  // 积压只随不同 key 的个数增长。key_of 为空时关闭；合并类型的事件与其他类型之间
+  // 不保证先后顺序
+  void set_conflation(EventType type, ConflationKeyFn key_of) {
+    std::unique_lock<std::shared_mutex> lock(conflation_mtx_);
+    if (key_of)
+      conflation_[type] = std::move(key_of);
+    else
+      conflation_.erase(type);
+  }
+
+  // 为连接追加订阅一个事件类型，重连后保持
+  void subscribe(ConnHandle h, EventType type) {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      Endpoint *ep = endpoint(h);
+      if (!ep)
+        return;
+      auto &types = ep->info.event_types;
+      if (std::find(types.begin(), types.end(), type) == types.end())
+        types.push_back(type);
+      sync_offline(*ep);
+    }
+    connections_.visit(h, [&](const ConnectionPtr &c) {
+      subscriptions_.add(type, c);
+    });
+  }
+
+  void subscribe(const std::string &key, EventType type) {
+    subscribe(find_handle(key), type);
+  }
+
+  void unsubscribe(ConnHandle h, EventType type) {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      Endpoint *ep = endpoint(h);
+      if (!ep)
+        return;
+      auto &types = ep->info.event_types;
+      types.erase(std::remove(types.begin(), types.end(), type), types.end());
+      sync_offline(*ep);
+    }
+    connections_.visit(h, [&](const ConnectionPtr &c) {
+      subscriptions_.remove(type, c);
+    });
+  }
+
+  void unsubscribe(const std::string &key, EventType type) {
+    unsubscribe(find_handle(key), type);
+  }
+
+private:
+  // 启用溢出的端点没有在线连接期间，代替连接订阅事件：事件写入端点的溢出队列，
+  // 重连后由新连接先于新消息补发。上线时先登记连接的订阅、后撤销离线订阅，
+  // 交接瞬间的事件可能两边各收一份，但不会两边都错过。
+  // 连接关闭到管理器收到断线回调之间（一次 strand 调度）到达的事件计入 disconnected
+  struct OfflineSpill {
+    ConnHandle handle;
+    std::shared_ptr<SpillStore> spill;
+    std::array<std::size_t, kEventTypeCount> sub_pos;  // 在 offline_subs_ 各表中的下标
+    bool offline = true;  // 端点当前没有在线连接，受 mtx_ 保护
+
+    OfflineSpill(ConnHandle h, std::shared_ptr<SpillStore> s) : handle(h), spill(std::move(s)) {
+      sub_pos.fill(kNotListed);
+    }
+  };
+
+  // 一个配置端点，下标即句柄的 index；key 只用于日志和按 key 查找
+  struct Endpoint {
+    ConnHandle handle;  // 无效表示空位
+    std::string key;
+    ConnInfo info;
+    unsigned retry_attempts = 0;  // 连续重连失败次数
+    std::shared_ptr<SpillStore> spill;  // 启用溢出时各代连接共用
+    std::shared_ptr<OfflineSpill> offline;  // 启用溢出时创建；endpoints_ 扩容时地址不变
+  };
+
+  static std::string make_key(const ConnInfo &info) {
+    return info.ip + ":" + std::to_string(info.port);
+  }
+
+  // 需持有 mtx_；句柄已失效时返回空
+  Endpoint *endpoint(ConnHandle h) {
+    if (!h.valid() || h.index >= endpoints_.size() ||
+        endpoints_[h.index].handle != h)
+      return nullptr;
+    return &endpoints_[h.index];
+  }
+
+  // 把一个事件投给 subs 中的每个订阅连接，结果累加到 res
+  void route_event(const SubscriptionIndex::List &subs, EventType type,
+                   const SharedMessage &msg, EventRouteResult &res) {
+    res.subscribers += subs.size();
+    std::string_view key = conflation_key(type, *msg);
+    for (const auto &c : subs) {
+      SendResult r = key.empty() ? c->enqueue_event(EventMsg{msg})
+                                 : c->enqueue_conflated(type, key, msg);
+      switch (r) {
+      case SendResult::CONFLATED:
+        ++res.conflated;
+        ++res.accepted;
+        break;
+      case SendResult::DROPPED_OLDEST:
+        ++res.dropped_oldest;
+        ++res.accepted;
+        break;
+      case SendResult::DROPPED:
+        ++res.dropped;
+        break;
+      case SendResult::REJECTED:
+        ++res.rejected;
+        break;
+      case SendResult::SPILLED:
+        ++res.spilled;
+        ++res.accepted;
+        break;
+      case SendResult::DISCONNECTED:
+      case SendResult::NO_CONNECTION:
+        ++res.disconnected;
+        break;
+      default:
+        ++res.accepted;
+        break;
+      }
+    }
+  }
+
+  // 把一个事件写入 offline 中每个离线端点的溢出队列，结果累加到 res。
+  // 不做合并：离线期间的事件全部按序保留
+  void spill_event(const MemberList<OfflineSpill>::List &offline, const SharedMessage &msg,
+                   EventRouteResult &res) {
+    res.subscribers += offline.size();
+    for (const auto &o : offline) {
+      if (append_spill(o->handle, *o->spill, Lane::NORMAL, *msg) == SendResult::SPILLED) {
+        ++res.spilled;
+        ++res.accepted;
+      } else {
+        ++res.rejected;
+      }
+    }
+  }
+
+  // 未开启合并或取不到 key 时返回空；返回值指向 msg 内部
+  std::string_view conflation_key(EventType type, const Connection::Message &msg) const {
+    std::shared_lock<std::shared_mutex> lock(conflation_mtx_);
+    auto it = conflation_.find(type);
+    if (it == conflation_.end())
+      return {};
+    return it->second(body_view(msg));
+  }
+
+  // 端点离线：启用了溢出的写入磁盘，等重连后补发
+  SendResult spill_offline(ConnHandle h, const Connection::Message &msg, Lane lane) {
+    if (lane == Lane::CONTROL)
+      return SendResult::NO_CONNECTION;
+    std::shared_ptr<SpillStore> spill;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (Endpoint *ep = endpoint(h))
+        spill = ep->spill;
+    }
+    if (!spill)
+      return SendResult::NO_CONNECTION;
+    return append_spill(h, *spill, lane, msg);
+  }
+
+  // 在连接之外写入端点的溢出队列。恰在此时上线的新连接可能已取空磁盘、写循环空闲，
+  // 队列由空变非空时提醒它取回
+  SendResult append_spill(ConnHandle h, SpillStore &spill, Lane lane,
+                          const Connection::Message &msg) {
+    bool was_empty = false;
+    if (!spill.append(static_cast<uint8_t>(lane), msg.data(), msg.size(), &was_empty))
+      return SendResult::REJECTED;
+    ConnectionPtr c;
+    if (was_empty && connections_.find(h, c))
+      c->resume_spill();
+    return SendResult::SPILLED;
+  }
+
+  // 需持有 mtx_：按端点是否在线与当前订阅，登记或撤销它在 offline_subs_ 中的离线订阅
+  void sync_offline(const Endpoint &ep) {
+    if (!ep.offline)
+      return;
+    OfflineSpill &o = *ep.offline;
+    const auto &types = ep.info.event_types;
+    for (std::size_t i = 0; i < kEventTypeCount; ++i) {
+      bool want = o.offline && std::find(types.begin(), types.end(),
+                                         static_cast<EventType>(i)) != types.end();
+      if (want)
+        offline_subs_[i].add(ep.offline, o.sub_pos[i]);
+      else
+        offline_subs_[i].remove(o.sub_pos[i]);
+    }
+  }
+
+  // 端点的连接上线或离线
+  void set_offline(ConnHandle h, bool offline) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Endpoint *ep = endpoint(h);
+    if (!ep || !ep->offline)
+      return;
+    ep->offline->offline = offline;
+    sync_offline(*ep);
+  }
+
+  // 需持有 mtx_：删除配置并归还句柄，在途的建连/退避随之作废
+  void drop_endpoint(ConnHandle h) {
+    Endpoint *ep = endpoint(h);
+    if (!ep)
+      return;
+    if (ep->offline) {
+      ep->offline->offline = false;
+      sync_offline(*ep);
+    }
+    handles_.erase(ep->key);
+    *ep = Endpoint();
+    connections_.release(h);
+  }
+
+  // 从配置中删除并静默关闭；句柄立即失效，同一 key 可马上重新添加
+  void remove_connection(ConnHandle h) {
+    ConnectionPtr conn;
+    connections_.exchange(h, nullptr, &conn);
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      drop_endpoint(h);
+    }
+    if (conn) {
+      subscriptions_.remove_all(conn);
+      groups_.remove(conn);
+      conn->close(false, false);
+    }
+  }
+
+  // 链路参数变化：摘除旧连接（不触发断线回调）并立即按新参数建连；
+  // 当前不在线的只更新配置，下一次重连自然使用新参数
+  void reopen_connection(const ConnInfo &info) {
+    ConnHandle h;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto it = handles_.find(make_key(info));
+      if (it == handles_.end())
+        return;
+      h = it->second;
+      endpoints_[h.index].info = info;
+      sync_offline(endpoints_[h.index]);
+    }
+    ConnectionPtr old;
+    if (!connections_.exchange(h, nullptr, &old) || !old)
+      return;
+    set_offline(h, true);
+    subscriptions_.remove_all(old);
+    groups_.remove(old);
+    old->close(false, false);
+    do_connect(h);
+  }
+
+  // 建连经过全局限流器排队；超时未连上则关闭 socket，按失败处理
+  void do_connect(ConnHandle h) {
+    ConnInfo info;
+    std::string key;
+    std::chrono::milliseconds timeout;
+    std::shared_ptr<SpillStore> spill;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      Endpoint *ep = endpoint(h);
+      if (!ep)
+        return;  // 已被热重载删除
+      info = ep->info;
+      key = ep->key;
+      timeout = policy_.connect_timeout;
+      spill = ep->spill;
+    }
+    auto conn = pool_ ? Connection::create(pool_->acquire(), key, info, wheel_)
+                      : Connection::create(io_context_, key, info, wheel_);
+    conn->set_spill(std::move(spill));
+
+    std::weak_ptr<ClientManager> wp = shared_from_this();
+    conn->set_disconnect_callback([wp, h](Connection *closed, bool need_reconnect) {
+      if (auto mgr = wp.lock())
+        mgr->on_connection_closed(h, closed, need_reconnect);
+    });
+
+    boost::asio::ip::tcp::endpoint ep(
+        boost::asio::ip::address::from_string(info.ip), info.port);
+    // 排队的任务随限流器（管理器成员）一起析构，执行时管理器必然存活；
+    // 建连完成回调则可能晚于管理器析构，只持弱引用
+    connect_limiter_.submit([this, wp, h, key, info, ep, conn, timeout] {
+      TimingWheel::TimerId timeout_id =
+          wheel_->schedule(timeout, [conn]() { conn->abort_connect(); });
+      conn->socket().async_connect(
+          ep, boost::asio::bind_executor(
+                  conn->strand(), [wp, wheel = wheel_, h, key, info, conn,
+                                   timeout_id](boost::system::error_code ec) {
+                    // 超时回调持有 conn，管理器已析构时也要取消，否则连接要等到超时才释放
+                    wheel->cancel(timeout_id);
+                    if (auto mgr = wp.lock())
+                      mgr->on_connect_done(h, key, info, conn, ec);
+                    else
+                      conn->close(false, false);
+                  }));
+    });
+  }
+
+  // 在连接的 strand 上：建连完成
+  void on_connect_done(ConnHandle h, const std::string &key, const ConnInfo &info,
+                       const ConnectionPtr &conn, boost::system::error_code ec) {
+    connect_limiter_.done(!ec);
+    if (ec) {
+      LOG_ERROR("Connect failed: {} : {}", key, ec.message());
+      retry_connect_later(h, key);
+      return;
+    }
+    std::string group;
+    GroupRouting routing;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      Endpoint *cur = endpoint(h);
+      if (!cur) {
+        conn->close(false, false);  // 建连期间被删除
+        return;
+      }
+      cur->retry_attempts = 0;
+      group = cur->info.group;  // 建连期间可能被热重载改组
+      routing = cur->info.group_routing;
+    }
+    ConnectionPtr prev;
+    if (!connections_.exchange(h, conn, &prev)) {
+      conn->close(false, false);
+      return;
+    }
+    if (prev) {  // 重复 add_connection 留下的旧连接
+      subscriptions_.remove_all(prev);
+      groups_.remove(prev);
+      prev->close(false, false);
+    }
+    for (EventType t : info.event_types)
+      subscriptions_.add(t, conn);
+    set_offline(h, false);  // 须在登记订阅之后，见 OfflineSpill
+    if (!group.empty())
+      groups_.add(group, routing, conn);
+    conn->start();
+    LOG_INFO("Connected: {}", key);
+  }
+
+  // 指数退避 + 抖动后重连；key 只用于日志
+  void retry_connect_later(ConnHandle h, const std::string &key) {
+    std::chrono::milliseconds delay = next_backoff(h);
+    LOG_INFO("Retry {} in {} ms", key, delay.count());
+    retry_waiting_.fetch_add(1, std::memory_order_relaxed);
+    std::weak_ptr<ClientManager> wp = shared_from_this();
+    wheel_->schedule(delay, [wp, h]() {
+      if (auto mgr = wp.lock()) {
+        mgr->retry_waiting_.fetch_sub(1, std::memory_order_relaxed);
+        mgr->do_connect(h);
+      }
+    });
+  }
+
+  std::chrono::milliseconds next_backoff(ConnHandle h) {
+    thread_local std::mt19937 rng{std::random_device{}()};
+    std::lock_guard<std::mutex> lock(mtx_);
+    Endpoint *ep = endpoint(h);
+    unsigned attempt = ep ? ep->retry_attempts++ : 0;
+    double cap = static_cast<double>(policy_.initial.count());
+    for (unsigned i = 0; i < attempt && cap < policy_.max.count(); ++i)
+      cap *= policy_.multiplier;
+    cap = std::min(cap, static_cast<double>(policy_.max.count()));
+    std::uniform_real_distribution<double> jitter(cap / 2, cap);
+    return std::chrono::milliseconds(static_cast<long long>(jitter(rng)));
+  }
+
+  static SharedMessage make_msg() {
+    return make_shared_message(std::string("hello\n"));
+  }
+
+  boost::asio::io_context &io_context_;
+  TimingWheel::Ptr wheel_;  // 心跳、重连退避、建连超时与事件攒批共用，连接各持一份
+  IoContextPool *pool_ = nullptr;  // 非空时为每核模式
+  ReconnectPolicy policy_;                      // 受 mtx_ 保护
+  ConnectLimiter connect_limiter_;
+  std::atomic<std::size_t> retry_waiting_{0};
+  std::vector<Endpoint> endpoints_;  // 配置，按句柄下标存放，冷路径，受 mtx_ 保护
+  std::unordered_map<std::string, ConnHandle> handles_;  // key -> 句柄，受 mtx_ 保护
+  SlotTable<ConnectionPtr> connections_;  // 句柄 -> 在线连接，槽位自带锁
+  SubscriptionIndex subscriptions_;       // EventType -> 订阅连接
+  // EventType -> 订阅该类型、启用溢出且当前离线的端点，下标为 EventType
+  std::array<MemberList<OfflineSpill>, kEventTypeCount> offline_subs_;
+  GroupIndex groups_;                     // 端点组 -> 在线成员
+  std::map<EventType, ConflationKeyFn> conflation_;  // 开启合并的事件类型，受 conflation_mtx_ 保护
+  mutable std::shared_mutex conflation_mtx_;
+  mutable std::mutex mtx_;
+};
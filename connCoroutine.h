@@ -0,0 +1,171 @@
+#pragma once
+
+// Boost 1.74 的 awaitable.hpp 用到 std::exchange 却未包含 <utility>，
+// C++20 下须在 asio 之前引入
+#include <utility>
+
+#include <boost/asio.hpp>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// 协程引擎只在 C++20 下可用；C++17 构建中 ConnEngine::COROUTINE 退回回调引擎
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define CLIENT_HAS_COROUTINES 1
+#include <coroutine>
+#include <exception>
+
+// ============ FramePool =============
+// 协程帧的线程本地复用池：不超过 kBlock 字节的帧按定长块缓存，每线程至多
+// kCached 块。连接的读写循环在建连时创建、断开时结束，重连风暴中帧内存
+// 在池里循环，不再反复走堆。帧不放在连接对象里：循环协程结束时可能正是
+// 它释放了连接的最后一个引用，帧内存须比连接活得久
+class FramePool {
+public:
+  static constexpr std::size_t kBlock = 512;
+  static constexpr std::size_t kCached = 256;
+
+  static void *allocate(std::size_t n) {
+    if (n > kBlock)
+      return ::operator new(n);
+    auto &c = cache();
+    if (c.empty())
+      return ::operator new(kBlock);
+    void *p = c.back();
+    c.pop_back();
+    return p;
+  }
+
+  static void deallocate(void *p, std::size_t n) {
+    if (n <= kBlock) {
+      auto &c = cache();
+      if (c.size() < kCached) {
+        c.push_back(p);
+        return;
+      }
+    }
+    ::operator delete(p);
+  }
+
+private:
+  struct Cache {
+    Cache() { blocks.reserve(kCached); }
+    ~Cache() {
+      for (void *p : blocks)
+        ::operator delete(p);
+    }
+    std::vector<void *> blocks;
+  };
+
+  static std::vector<void *> &cache() {
+    thread_local Cache c;
+    return c.blocks;
+  }
+};
+
+// ============ CoTask =============
+// 立即开始、结束即销毁的协程，不向调用方返回结果；帧取自 FramePool
+struct CoTask {
+  struct promise_type {
+    CoTask get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+
+    static void *operator new(std::size_t n) { return FramePool::allocate(n); }
+    static void operator delete(void *p, std::size_t n) noexcept {
+      FramePool::deallocate(p, n);
+    }
+  };
+};
+
+// ============ CoSignal =============
+// 单个等待者的唤醒点，只在所属 strand 上使用：
+// co_await wait(keep) 挂起当前协程，notify() 就地恢复它（没有等待者时什么也不做）。
+// 析构时销毁仍在等待的协程帧
+class CoSignal {
+public:
+  CoSignal() = default;
+  CoSignal(const CoSignal &) = delete;
+  CoSignal &operator=(const CoSignal &) = delete;
+  ~CoSignal() {
+    if (waiter_)
+      waiter_.destroy();
+  }
+
+  // keep 在协程挂起之后才释放：协程用它持有所属对象的 shared_ptr 时，
+  // 等待期间不再延长对象寿命；若这恰是最后一个引用，对象析构时经由
+  // 本 CoSignal 的析构销毁刚挂起的帧
+  template <typename Keep> auto wait(Keep keep) {
+    struct Awaiter {
+      CoSignal &sig;
+      Keep keep;
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> h) noexcept {
+        sig.waiter_ = h;
+        Keep drop = std::move(keep);  // 之后不得再访问 this
+      }
+      void await_resume() const noexcept {}
+    };
+    return Awaiter{*this, std::move(keep)};
+  }
+
+  void notify() {
+    if (auto h = std::exchange(waiter_, nullptr))
+      h.resume();
+  }
+
+private:
+  std::coroutine_handle<> waiter_;
+};
+
+// ============ async_io =============
+// 把一次 (error_code, size_t) 完成签名的 asio 异步操作变成可 co_await 的对象：
+// initiate(handler) 负责发起操作并自行包上 strand / 分配器，完成回调直接恢复协程，
+// 不经过 use_awaitable 的中间协程帧。回调未执行就被销毁（io_context 停止）时
+// 一并销毁协程帧，帧内持有的对象得以释放
+struct IoResult {
+  boost::system::error_code ec;
+  std::size_t bytes = 0;
+};
+
+template <typename Initiate> class IoAwaiter {
+public:
+  explicit IoAwaiter(Initiate init) : init_(std::move(init)) {}
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> h) { init_(Resume(this, h)); }
+  IoResult await_resume() const noexcept { return result_; }
+
+private:
+  class Resume {
+  public:
+    Resume(IoAwaiter *aw, std::coroutine_handle<> h) : aw_(aw), h_(h) {}
+    Resume(Resume &&o) noexcept : aw_(o.aw_), h_(std::exchange(o.h_, nullptr)) {}
+    Resume &operator=(Resume &&) = delete;
+    ~Resume() {
+      if (h_)
+        h_.destroy();
+    }
+
+    void operator()(boost::system::error_code ec, std::size_t n) {
+      aw_->result_.ec = ec;
+      aw_->result_.bytes = n;
+      std::exchange(h_, nullptr).resume();
+    }
+
+  private:
+    IoAwaiter *aw_;
+    std::coroutine_handle<> h_;
+  };
+
+  Initiate init_;
+  IoResult result_;
+};
+
+template <typename Initiate> IoAwaiter<Initiate> async_io(Initiate init) {
+  return IoAwaiter<Initiate>(std::move(init));
+}
+
+#endif  // coroutines
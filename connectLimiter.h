@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+// ============ 建连统计 ============
+struct ConnectStats {
+  std::size_t active = 0;     // 正在进行的 async_connect 数
+  std::size_t queued = 0;     // 等待名额的建连请求数
+  std::size_t peak_queued = 0;
+  uint64_t started = 0;       // 累计发起
+  uint64_t succeeded = 0;
+  uint64_t failed = 0;
+  std::size_t retry_waiting = 0;  // 处于退避等待中的连接数（由 ClientManager 填写）
+};
+
+// ============ ConnectLimiter =============
+// 全局限制同时在途的 async_connect 数量。交换机抖动或热重载时成千上万的
+// 重连请求先进入 FIFO 排队，每完成一个建连（成功或失败）再放行下一个，
+// 避免同一时刻发起大量 SYN。
+class ConnectLimiter {
+public:
+  using Task = std::function<void()>;
+
+  explicit ConnectLimiter(std::size_t max_inflight) : limit_(max_inflight) {}
+
+  // 有空闲名额则立即在当前线程执行 task，否则排队；task 内必须发起建连，
+  // 并在建连完成时调用一次 done(ok)
+  void submit(Task task) {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (stats_.active >= limit_) {
+        pending_.push_back(std::move(task));
+        stats_.queued = pending_.size();
+        if (stats_.queued > stats_.peak_queued)
+          stats_.peak_queued = stats_.queued;
+        return;
+      }
+      ++stats_.active;
+      ++stats_.started;
+    }
+    task();
+  }
+
+  void done(bool ok) {
+    Task next;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      --stats_.active;
+      ++(ok ? stats_.succeeded : stats_.failed);
+      if (pending_.empty() || stats_.active >= limit_)
+        return;
+      next = std::move(pending_.front());
+      pending_.pop_front();
+      stats_.queued = pending_.size();
+      ++stats_.active;
+      ++stats_.started;
+    }
+    next();
+  }
+
+  void set_limit(std::size_t limit) {
+    std::deque<Task> ready;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      limit_ = limit ? limit : 1;
+      while (!pending_.empty() && stats_.active < limit_) {
+        ready.push_back(std::move(pending_.front()));
+        pending_.pop_front();
+        ++stats_.active;
+        ++stats_.started;
+      }
+      stats_.queued = pending_.size();
+    }
+    for (auto &t : ready)
+      t();
+  }
+
+  ConnectStats stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_;
+  }
+
+private:
+  mutable std::mutex mtx_;
+  std::size_t limit_;
+  std::deque<Task> pending_;
+  ConnectStats stats_;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <boost/asio.hpp>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// ============ HandlerMemory =============
+// 完成回调（连同 asio 内部的操作对象）的复用内存：固定 Slots 个 SlotSize 字节的块。
+// 一条连接在途的 async_write / async_read / post 数量有上限，稳态下每次都能
+// 拿到空闲块，收发路径不再走堆；块不够或对象过大时退回 ::operator new。
+// 块的占用标志是原子的：生产者线程 post 时分配、IO 线程执行完释放也安全。
+template <std::size_t Slots = 4, std::size_t SlotSize = 256> class HandlerMemory {
+public:
+  HandlerMemory() {
+    for (auto &f : in_use_)
+      f.store(false, std::memory_order_relaxed);
+  }
+
+  HandlerMemory(const HandlerMemory &) = delete;
+  HandlerMemory &operator=(const HandlerMemory &) = delete;
+
+  void *allocate(std::size_t size) {
+    if (size <= SlotSize) {
+      for (std::size_t i = 0; i < Slots; ++i) {
+        if (!in_use_[i].load(std::memory_order_relaxed) &&
+            !in_use_[i].exchange(true, std::memory_order_acquire))
+          return &storage_[i];
+      }
+    }
+    fallbacks_.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size);
+  }
+
+  void deallocate(void *p) {
+    for (std::size_t i = 0; i < Slots; ++i) {
+      if (p == &storage_[i]) {
+        in_use_[i].store(false, std::memory_order_release);
+        return;
+      }
+    }
+    ::operator delete(p);
+  }
+
+  // 未能复用、退回堆分配的次数
+  std::size_t fallbacks() const {
+    return fallbacks_.load(std::memory_order_relaxed);
+  }
+
+private:
+  typename std::aligned_storage<SlotSize, alignof(std::max_align_t)>::type
+      storage_[Slots];
+  std::atomic<bool> in_use_[Slots];
+  std::atomic<std::size_t> fallbacks_{0};
+};
+
+// ============ HandlerAllocator =============
+// 满足 asio 对 associated_allocator 的要求，从 HandlerMemory 取块
+template <typename T, typename Memory> class HandlerAllocator {
+public:
+  using value_type = T;
+
+  explicit HandlerAllocator(Memory &mem) : mem_(&mem) {}
+
+  template <typename U>
+  HandlerAllocator(const HandlerAllocator<U, Memory> &o) noexcept
+      : mem_(o.mem_) {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(mem_->allocate(sizeof(T) * n));
+  }
+
+  void deallocate(T *p, std::size_t) { mem_->deallocate(p); }
+
+  template <typename U>
+  bool operator==(const HandlerAllocator<U, Memory> &o) const noexcept {
+    return mem_ == o.mem_;
+  }
+  template <typename U>
+  bool operator!=(const HandlerAllocator<U, Memory> &o) const noexcept {
+    return mem_ != o.mem_;
+  }
+
+private:
+  template <typename, typename> friend class HandlerAllocator;
+  Memory *mem_;
+};
+
+// ============ AllocHandler =============
+// 给回调挂上 allocator_type / get_allocator()，asio 据此为操作对象分配内存；
+// 外层再套 bind_executor 时分配器会被透传
+template <typename Handler, typename Memory> class AllocHandler {
+public:
+  using allocator_type = HandlerAllocator<Handler, Memory>;
+
+  AllocHandler(Memory &mem, Handler h) : mem_(mem), handler_(std::move(h)) {}
+
+  allocator_type get_allocator() const noexcept { return allocator_type(mem_); }
+
+  template <typename... Args> void operator()(Args &&...args) {
+    handler_(std::forward<Args>(args)...);
+  }
+
+private:
+  Memory &mem_;
+  Handler handler_;
+};
+
+template <typename Handler, typename Memory>
+inline AllocHandler<typename std::decay<Handler>::type, Memory>
+make_alloc_handler(Memory &mem, Handler &&h) {
+  return AllocHandler<typename std::decay<Handler>::type, Memory>(
+      mem, std::forward<Handler>(h));
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+// ============ IoContextPool =============
+// 每核一个 io_context、每个 io_context 只由一个线程运行：
+// 连接在建立时被固定到某个 io_context，之后它的所有回调都在同一线程上执行，
+// strand 不再有跨线程竞争，连接状态也留在同一核的缓存里。
+// 放置策略为最少负载：选择当前连接数最少的 io_context。
+class IoContextPool {
+public:
+  // 连接占用的放置名额，析构时归还（随 Connection 一起释放）
+  class Lease {
+  public:
+    Lease() = default;
+    Lease(IoContextPool *pool, std::size_t index) : pool_(pool), index_(index) {}
+    Lease(Lease &&o) noexcept : pool_(o.pool_), index_(o.index_) {
+      o.pool_ = nullptr;
+    }
+    Lease &operator=(Lease &&o) noexcept {
+      if (this != &o) {
+        reset();
+        pool_ = o.pool_;
+        index_ = o.index_;
+        o.pool_ = nullptr;
+      }
+      return *this;
+    }
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+    ~Lease() { reset(); }
+
+    explicit operator bool() const { return pool_ != nullptr; }
+    std::size_t index() const { return index_; }
+    boost::asio::io_context &context() const { return pool_->context(index_); }
+
+  private:
+    void reset() {
+      if (pool_)
+        pool_->loads_[index_].fetch_sub(1, std::memory_order_relaxed);
+      pool_ = nullptr;
+    }
+
+    IoContextPool *pool_ = nullptr;
+    std::size_t index_ = 0;
+  };
+
+  explicit IoContextPool(std::size_t n = std::thread::hardware_concurrency())
+      : loads_(new std::atomic<std::size_t>[std::max<std::size_t>(n, 1)]) {
+    n = std::max<std::size_t>(n, 1);
+    for (std::size_t i = 0; i < n; ++i) {
+      // 并发提示为 1：单线程运行，调度器可省去内部锁
+      contexts_.emplace_back(new boost::asio::io_context(1));
+      guards_.emplace_back(boost::asio::make_work_guard(*contexts_.back()));
+      loads_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  IoContextPool(const IoContextPool &) = delete;
+  IoContextPool &operator=(const IoContextPool &) = delete;
+
+  ~IoContextPool() {
+    stop();
+    join();
+    // 先销毁 io_context：未执行的回调可能持有 Connection，
+    // 其 Lease 析构时还要访问 loads_
+    contexts_.clear();
+  }
+
+  // 为每个 io_context 启动一个线程，pin_threads 时绑定到对应 CPU
+  void run(bool pin_threads = true) {
+    for (std::size_t i = 0; i < contexts_.size(); ++i) {
+      threads_.emplace_back([this, i] { contexts_[i]->run(); });
+#ifdef __linux__
+      if (pin_threads) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(i % std::max(1u, std::thread::hardware_concurrency()), &set);
+        pthread_setaffinity_np(threads_.back().native_handle(), sizeof(set),
+                               &set);
+      }
+#else
+      (void)pin_threads;
+#endif
+    }
+  }
+
+  void stop() {
+    guards_.clear();
+    for (auto &ctx : contexts_)
+      ctx->stop();
+  }
+
+  void join() {
+    for (auto &t : threads_)
+      if (t.joinable())
+        t.join();
+    threads_.clear();
+  }
+
+  std::size_t size() const { return contexts_.size(); }
+  boost::asio::io_context &context(std::size_t i) { return *contexts_[i]; }
+
+  std::size_t load(std::size_t i) const {
+    return loads_[i].load(std::memory_order_relaxed);
+  }
+
+  // 最少负载放置；并发放置时计数为近似值，偏差至多为并发数
+  Lease acquire() {
+    std::size_t best = 0;
+    std::size_t best_load = load(0);
+    for (std::size_t i = 1; i < contexts_.size(); ++i) {
+      std::size_t l = load(i);
+      if (l < best_load) {
+        best = i;
+        best_load = l;
+      }
+    }
+    loads_[best].fetch_add(1, std::memory_order_relaxed);
+    return Lease(this, best);
+  }
+
+private:
+  using WorkGuard =
+      boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+  std::vector<std::unique_ptr<boost::asio::io_context>> contexts_;
+  std::vector<WorkGuard> guards_;
+  std::vector<std::thread> threads_;
+  std::unique_ptr<std::atomic<std::size_t>[]> loads_;
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// ============ 延迟摘要 ============
+// 单位均为微秒；百分位取所在桶的中点，相对误差约 1/64
+struct LatencySummary {
+  uint64_t count = 0;
+  double mean_us = 0;
+  double p50_us = 0;
+  double p90_us = 0;
+  double p99_us = 0;
+  double p999_us = 0;
+  double max_us = 0;
+};
+
+// ============ 对数-线性分桶 ============
+// 与 HdrHistogram 相同的布局：[0, 64) 逐微秒一桶，之后每个 2 的幂区间
+// 均分为 32 个子桶，桶宽随数值翻倍，相对精度恒定；
+// 上限 2^30us（约 18 分钟），超出的样本计入最后一个桶
+namespace latency_detail {
+constexpr unsigned kSubBits = 5;
+constexpr std::size_t kSub = std::size_t(1) << kSubBits;
+constexpr unsigned kMaxBits = 30;
+constexpr std::size_t kBuckets = (kMaxBits - kSubBits + 1) * kSub;
+
+inline std::size_t bucket_of(uint64_t v) {
+  if (v < 2 * kSub)
+    return static_cast<std::size_t>(v);
+  unsigned msb = 63 - __builtin_clzll(v);
+  if (msb >= kMaxBits)
+    return kBuckets - 1;
+  unsigned shift = msb - kSubBits;
+  return shift * kSub + static_cast<std::size_t>(v >> shift);
+}
+
+// 桶中点
+inline double bucket_value(std::size_t idx) {
+  if (idx < 2 * kSub)
+    return static_cast<double>(idx);
+  unsigned shift = static_cast<unsigned>(idx / kSub) - 1;
+  uint64_t lo = static_cast<uint64_t>(idx % kSub + kSub) << shift;
+  return lo + (uint64_t(1) << shift) / 2.0;
+}
+} // namespace latency_detail
+
+// ============ LatencySnapshot =============
+// 某一时刻的桶计数拷贝，可跨连接合并后再求百分位
+class LatencySnapshot {
+public:
+  LatencySnapshot() : counts_(latency_detail::kBuckets, 0) {}
+
+  void merge(const LatencySnapshot &o) {
+    for (std::size_t i = 0; i < counts_.size(); ++i)
+      counts_[i] += o.counts_[i];
+    count_ += o.count_;
+    sum_ += o.sum_;
+    max_ = std::max(max_, o.max_);
+  }
+
+  uint64_t count() const { return count_; }
+
+  // q 取 [0, 1]
+  double percentile(double q) const {
+    if (count_ == 0)
+      return 0;
+    uint64_t rank = static_cast<uint64_t>(q * count_ + 0.5);
+    rank = std::min(std::max<uint64_t>(rank, 1), count_);
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+      seen += counts_[i];
+      if (seen >= rank)
+        return std::min(latency_detail::bucket_value(i),
+                        static_cast<double>(max_));
+    }
+    return static_cast<double>(max_);
+  }
+
+  LatencySummary summary() const {
+    LatencySummary s;
+    s.count = count_;
+    if (count_ == 0)
+      return s;
+    s.mean_us = static_cast<double>(sum_) / count_;
+    s.p50_us = percentile(0.50);
+    s.p90_us = percentile(0.90);
+    s.p99_us = percentile(0.99);
+    s.p999_us = percentile(0.999);
+    s.max_us = static_cast<double>(max_);
+    return s;
+  }
+
+private:
+  friend class LatencyHistogram;
+  std::vector<uint64_t> counts_;
+  uint64_t count_ = 0;
+  uint64_t sum_ = 0;
+  uint64_t max_ = 0;
+};
+
+// ============ LatencyHistogram =============
+// 单写多读：record() 只在连接的 strand 上调用，用 relaxed load+store
+// 代替原子加（无 lock 前缀），snapshot() 可在任意线程调用，结果为近似快照。
+// 桶数组固定约 6.5KB，记录一次只有一次 clz 和几次不带 lock 前缀的读写
+class LatencyHistogram {
+public:
+  LatencyHistogram() : buckets_(new std::atomic<uint64_t>[latency_detail::kBuckets]) {
+    for (std::size_t i = 0; i < latency_detail::kBuckets; ++i)
+      buckets_[i].store(0, std::memory_order_relaxed);
+  }
+
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+  void record(uint64_t us) {
+    bump(buckets_[latency_detail::bucket_of(us)], 1);
+    bump(count_, 1);
+    bump(sum_, us);
+    if (us > max_.load(std::memory_order_relaxed))
+      max_.store(us, std::memory_order_relaxed);
+  }
+
+  LatencySnapshot snapshot() const {
+    LatencySnapshot s;
+    uint64_t n = 0;
+    for (std::size_t i = 0; i < latency_detail::kBuckets; ++i) {
+      s.counts_[i] = buckets_[i].load(std::memory_order_relaxed);
+      n += s.counts_[i];
+    }
+    s.count_ = n;  // 以桶为准，避免与 count_ 读取时刻不一致
+    s.sum_ = sum_.load(std::memory_order_relaxed);
+    s.max_ = max_.load(std::memory_order_relaxed);
+    return s;
+  }
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+private:
+  static void bump(std::atomic<uint64_t> &a, uint64_t d) {
+    a.store(a.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+  }
+
+  std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
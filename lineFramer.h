@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+#include "readBuffer.h"
+
+// ============ LineFramer =============
+// 基于 ReadBuffer 的按行分帧器：
+//   - prepare() 返回缓冲区尾部空闲区，socket 直接读入；
+//   - commit(n, f) 用 memchr（glibc 下为 SIMD 实现）只扫描新到的字节，
+//     每找到一个分隔符就以 string_view 把整帧（不含分隔符）交给 f，不分配内存；
+//     一次读到的所有完整帧都会被交出，残余的半帧留在缓冲区等待下次读；
+//   - 单帧最长为缓冲区容量，超长时 prepare() 返回空闲长度 0。
+class LineFramer {
+public:
+  explicit LineFramer(std::size_t capacity = 64 * 1024, char delim = '\n')
+      : buf_(capacity), delim_(delim) {}
+
+  std::pair<char *, std::size_t> prepare() { return buf_.prepare(); }
+
+  // 提交刚读入的 n 字节，对其中每个完整帧调用 f(std::string_view)，返回帧数
+  template <typename F> std::size_t commit(std::size_t n, F &&f) {
+    std::size_t scan = buf_.tail();  // 之前的字节已扫描过，不含分隔符
+    buf_.produce(n);
+    const char *data = buf_.data();
+    std::size_t tail = buf_.tail();
+    std::size_t frames = 0;
+    while (scan < tail) {
+      const void *hit = std::memchr(data + scan, delim_, tail - scan);
+      if (!hit)
+        break;
+      std::size_t end = static_cast<const char *>(hit) - data;
+      f(std::string_view(data + buf_.head(), end - buf_.head()));
+      buf_.consume_to(end + 1);
+      scan = end + 1;
+      ++frames;
+    }
+    return frames;
+  }
+
+  std::size_t pending_bytes() const { return buf_.pending_bytes(); }
+
+private:
+  ReadBuffer buf_;
+  char delim_;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+// 成员不在表中时的下标
+constexpr std::size_t kNotListed = static_cast<std::size_t>(-1);
+
+// ============ MemberList =============
+// 读多写少、成员成批进出的集合（订阅表、端点组），供路由取快照后无锁遍历。
+// 连接的建立与断开常常成批到来（重连风暴、数万连接同时上下线），所以读写分开处理：
+//   - 写：成员自己保存它在本表中的下标，加入即追加到表尾，移除时与表尾交换后弹出，
+//     被换过来的成员经登记的位置更新下标；都是 O(1)，不复制整张表；
+//   - 读：snapshot() 返回不可变快照，取出后无锁遍历。变化只把表标记为脏，
+//     下一次读取时重建一次快照，两次读取之间的任意多次变化合并为一次复制。
+// 刚移除的成员仍可能在他人持有的旧快照里，由使用方自行判断其是否仍然有效
+template <typename T> class MemberList {
+public:
+  using Ptr = std::shared_ptr<T>;
+  using List = std::vector<Ptr>;
+  using ListPtr = std::shared_ptr<const List>;
+
+  // pos 是 m 保存自己在本表中下标的位置，未加入时为 kNotListed；
+  // pos 须随 m 存活，且只经本表读写。已在表中时返回 false
+  bool add(const Ptr &m, std::size_t &pos) {
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    if (pos != kNotListed)
+      return false;
+    pos = members_.size();
+    members_.push_back(Entry{m, &pos});
+    dirty_ = true;
+    return true;
+  }
+
+  // pos 同 add；不在表中时返回 false
+  bool remove(std::size_t &pos) {
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    if (pos == kNotListed)
+      return false;
+    if (pos + 1 != members_.size()) {
+      members_[pos] = std::move(members_.back());
+      *members_[pos].pos = pos;
+    }
+    members_.pop_back();
+    pos = kNotListed;
+    dirty_ = true;
+    return true;
+  }
+
+  // 没有成员时返回空
+  ListPtr snapshot() const {
+    {
+      std::shared_lock<std::shared_mutex> lock(mtx_);
+      if (!dirty_)
+        return snapshot_;
+    }
+    std::unique_lock<std::shared_mutex> lock(mtx_);
+    if (dirty_) {  // 并发的读者中只有第一个重建
+      if (members_.empty()) {
+        snapshot_.reset();
+      } else {
+        auto list = std::make_shared<List>();
+        list->reserve(members_.size());
+        for (const auto &e : members_)
+          list->push_back(e.member);
+        snapshot_ = std::move(list);
+      }
+      dirty_ = false;
+    }
+    return snapshot_;
+  }
+
+  std::size_t size() const {
+    std::shared_lock<std::shared_mutex> lock(mtx_);
+    return members_.size();
+  }
+
+private:
+  struct Entry {
+    Ptr member;
+    std::size_t *pos;  // 指向成员自己保存的下标
+  };
+
+  mutable std::shared_mutex mtx_;
+  std::vector<Entry> members_;  // 当前成员，顺序无意义
+  mutable ListPtr snapshot_;    // 最近一次发布给读者的快照
+  mutable bool dirty_ = false;
+};
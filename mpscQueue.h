@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// ============ MpscQueue =============
+// 无锁多生产者/单消费者队列：
+//   - 生产者 push 只做一次 CAS，永不阻塞在消费者（IO 线程）上；
+//   - 消费者 drain 用一次 exchange 摘下整条链表，反转成 FIFO 后
+//     逐个把元素 move 给回调，不拷贝、不持锁；
+//   - push 返回入队前队列是否为空，调用方据此只在“空 -> 非空”时
+//     安排一次消费，之后的生产者无需再通知。
+template <typename T> class MpscQueue {
+public:
+  MpscQueue() = default;
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  ~MpscQueue() {
+    drain([](T &&) {});
+  }
+
+  // 可在任意线程调用
+  bool push(T value) {
+    Node *node = new Node{std::move(value), nullptr};
+    Node *old = head_.load(std::memory_order_relaxed);
+    do {
+      node->next = old;
+    } while (!head_.compare_exchange_weak(old, node, std::memory_order_release,
+                                          std::memory_order_relaxed));
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return old == nullptr;
+  }
+
+  // 仅消费者线程调用；按入队顺序对每个元素调用 f(T&&)，返回取出个数
+  template <typename F> std::size_t drain(F &&f) {
+    Node *list = head_.exchange(nullptr, std::memory_order_acquire);
+    if (!list)
+      return 0;
+    Node *fifo = nullptr;
+    while (list) {
+      Node *next = list->next;
+      list->next = fifo;
+      fifo = list;
+      list = next;
+    }
+    std::size_t n = 0;
+    while (fifo) {
+      Node *next = fifo->next;
+      f(std::move(fifo->value));
+      delete fifo;
+      fifo = next;
+      ++n;
+    }
+    size_.fetch_sub(n, std::memory_order_relaxed);
+    return n;
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) == nullptr;
+  }
+
+  // 近似长度，仅供统计/阈值判断
+  std::size_t size_approx() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Node {
+    T value;
+    Node *next;
+  };
+
+  alignas(64) std::atomic<Node *> head_{nullptr};
+  alignas(64) std::atomic<std::size_t> size_{0};
+};
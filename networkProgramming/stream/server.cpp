@@ -1,5 +1,6 @@
 #include <iostream>
 #include <boost/asio.hpp>
+#include "../../asyncLogger.h"
 
 using boost::asio::ip::tcp;
 
@@ -30,21 +31,17 @@ struct EventInfo {
 #pragma pack(pop)
 
 void handleReceivedData(EventInfo* event) {
-    std::cout << "Received Event Information:" << std::endl;
-    std::cout << "IP Address: " << event->ipAddress << std::endl;
-    std::cout << "Port No: " << event->portNo << std::endl;
-    std::cout << "Protocol: " << event->protocol << std::endl;
-    std::cout << "MAC Address: " << event->macAddress << std::endl;
-    std::cout << "Channel ID: " << event->channelID << std::endl;
-    std::cout << "DateTime: " << event->dateTime << std::endl;
-    std::cout << "Active Post Count: " << event->activePostCount << std::endl;
-    std::cout << "Event Type: " << event->eventType << std::endl;
-    std::cout << "Event State: " << event->eventState << std::endl;
-    std::cout << "Event Description: " << event->eventDescription << std::endl;
-    std::cout << "Stop Line Distance: " << event->stopLineDistance << std::endl;
-    std::cout << "Radar Detect Distance: " << event->radarDetectDistance << std::endl;
-    std::cout << "Freezing Timestamp: " << event->freezingTimeInfo.freezingTimestamp << std::endl;
-    std::cout << "Freezing System DateTime: " << event->freezingTimeInfo.freezingSystemDateTime << std::endl;
+    LOG_INFO("Received Event Information: IP Address: {} Port No: {} Protocol: {} "
+             "MAC Address: {} Channel ID: {} DateTime: {} Active Post Count: {}",
+             event->ipAddress, event->portNo, event->protocol, event->macAddress,
+             event->channelID, event->dateTime, event->activePostCount);
+    LOG_INFO("Event Type: {} Event State: {} Event Description: {}",
+             event->eventType, event->eventState, event->eventDescription);
+    LOG_INFO("Stop Line Distance: {} Radar Detect Distance: {} "
+             "Freezing Timestamp: {} Freezing System DateTime: {}",
+             event->stopLineDistance, event->radarDetectDistance,
+             event->freezingTimeInfo.freezingTimestamp,
+             event->freezingTimeInfo.freezingSystemDateTime);
 }
 
 class Session : public std::enable_shared_from_this<Session> {
@@ -65,7 +62,7 @@ private:
                     handleReceivedData(&event_);
                     doRead(); // ȡһ
                 } else {
-                    std::cerr << "Read Error: " << ec.message() << std::endl;
+                    LOG_ERROR("Read Error: {}", ec.message());
                 }
             });
     }
@@ -88,7 +85,7 @@ private:
             if (!ec) {
                 std::make_shared<Session>(std::move(*socket))->start();
             } else {
-                std::cerr << "Accept Error: " << ec.message() << std::endl;
+                LOG_ERROR("Accept Error: {}", ec.message());
             }
             startAccept();
         });
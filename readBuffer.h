@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+// ============ ReadBuffer =============
+// 分帧器共用的可复用读缓冲区（LineFramer 按行、RespReader 按 RESP 值）：
+//   - prepare() 返回尾部空闲区，socket 直接读入，无中间 streambuf；
+//   - [head, tail) 为已读入、尚未交出的字节，由分帧器自行解析，
+//     交出完整帧后 consume_to() 前移 head；
+//   - 读指针追上写指针时整体复位，空闲区不足 1/4 时把残余的半帧搬回头部，
+//     单帧最长为缓冲区容量，超长时 prepare() 返回空闲长度 0。
+class ReadBuffer {
+public:
+  explicit ReadBuffer(std::size_t capacity) : buf_(new char[capacity]), cap_(capacity) {}
+
+  std::pair<char *, std::size_t> prepare() {
+    if (head_ == tail_) {
+      head_ = tail_ = 0;
+    } else if (cap_ - tail_ < cap_ / 4 && head_ > 0) {
+      std::size_t len = tail_ - head_;
+      std::memmove(buf_.get(), buf_.get() + head_, len);
+      head_ = 0;
+      tail_ = len;
+    }
+    return {buf_.get() + tail_, cap_ - tail_};
+  }
+
+  // 提交刚读入 prepare() 空闲区的 n 字节
+  void produce(std::size_t n) { tail_ += n; }
+
+  // pos 之前的字节已交出
+  void consume_to(std::size_t pos) { head_ = pos; }
+
+  const char *data() const { return buf_.get(); }
+  std::size_t head() const { return head_; }
+  std::size_t tail() const { return tail_; }
+  std::size_t pending_bytes() const { return tail_ - head_; }
+
+private:
+  std::unique_ptr<char[]> buf_;
+  std::size_t cap_;
+  std::size_t head_ = 0;  // 当前未完成帧的起点
+  std::size_t tail_ = 0;  // 已读入数据的末尾
+};
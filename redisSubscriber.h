@@ -0,0 +1,292 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "clientManager.h"
+#include "respParser.h"
+
+// ============ Redis 订阅参数 ============
+struct RedisSubscriberConfig {
+  std::string host = "127.0.0.1";  // IP 地址
+  uint16_t port = 6379;
+  std::string password;  // 非空时先 AUTH
+  bool resp3 = false;    // 先 HELLO 3，推送以 > 帧到达；否则为 RESP2 的 * 数组
+  std::vector<std::pair<std::string, EventType>> channels;  // SUBSCRIBE 频道 -> 事件类型
+  std::vector<std::pair<std::string, EventType>> patterns;  // PSUBSCRIBE 模式 -> 事件类型
+  std::size_t read_buffer_size = 1 << 20;  // 也是单条推送的最大长度
+  std::size_t batch_max = 1024;            // 单次 on_redis_events 的事件数上限
+  std::chrono::milliseconds reconnect_initial{100};
+  std::chrono::milliseconds reconnect_max{5000};
+};
+
+// ============ Redis 订阅统计 ============
+struct RedisSubscriberStats {
+  uint64_t messages = 0;   // 已投递给 ClientManager 的推送
+  uint64_t bytes = 0;      // 对应的消息体字节数
+  uint64_t batches = 0;    // on_redis_events 调用次数
+  uint64_t unmapped = 0;   // 频道/模式未配置而丢弃的推送
+  uint64_t reconnects = 0;
+};
+
+// ============ RedisSubscriber =============
+// 与 ClientManager 共用 io_context 的异步 RESP2/RESP3 订阅客户端：
+//   - 建连后一次写出 AUTH / HELLO 3 / SUBSCRIBE / PSUBSCRIBE，之后只读；
+//   - 读入 RespReader 的复用缓冲区，就地解析 message / pmessage 推送，
+//     频道与模式以 string_view 比对配置，不构造中间字符串；
+//   - 一次读到的推送攒成一批交给 ClientManager::on_redis_events，
+//     每条分配两次：事件体（附加换行）的 vector 与 SharedMessage 的控制块，
+//     之后由所有订阅连接共享，不再逐连接复制；
+//   - 断开后按指数退避重连并重新订阅。
+// 所有回调在自身 strand 上执行；ClientManager 以弱引用持有，先于本对象销毁时不再投递。
+class RedisSubscriber : public std::enable_shared_from_this<RedisSubscriber> {
+public:
+  using Ptr = std::shared_ptr<RedisSubscriber>;
+
+  static Ptr create(boost::asio::io_context &io, RedisSubscriberConfig config,
+                    const std::shared_ptr<ClientManager> &manager) {
+    return Ptr(new RedisSubscriber(io, std::move(config), manager));
+  }
+
+  void start() {
+    auto self = shared_from_this();
+    boost::asio::post(strand_, [this, self]() {
+      stopped_ = false;
+      do_connect();
+    });
+  }
+
+  void stop() {
+    auto self = shared_from_this();
+    boost::asio::post(strand_, [this, self]() {
+      stopped_ = true;
+      timer_.cancel();
+      boost::system::error_code ec;
+      socket_.close(ec);
+    });
+  }
+
+  // 可在任意线程调用，计数为近似快照
+  RedisSubscriberStats stats() const {
+    RedisSubscriberStats st;
+    st.messages = stat_messages_.load(std::memory_order_relaxed);
+    st.bytes = stat_bytes_.load(std::memory_order_relaxed);
+    st.batches = stat_batches_.load(std::memory_order_relaxed);
+    st.unmapped = stat_unmapped_.load(std::memory_order_relaxed);
+    st.reconnects = stat_reconnects_.load(std::memory_order_relaxed);
+    return st;
+  }
+
+  bool connected() const { return connected_.load(std::memory_order_relaxed); }
+
+private:
+  RedisSubscriber(boost::asio::io_context &io, RedisSubscriberConfig config,
+                  const std::shared_ptr<ClientManager> &manager)
+      : io_(io), config_(std::move(config)), manager_(manager), socket_(io),
+        strand_(boost::asio::make_strand(io)), timer_(io),
+        reader_(config_.read_buffer_size), backoff_(config_.reconnect_initial) {
+    batch_.reserve(config_.batch_max);
+  }
+
+  void do_connect() {
+    if (stopped_)
+      return;
+    boost::system::error_code ec;
+    socket_ = boost::asio::ip::tcp::socket(io_);
+    boost::asio::ip::tcp::endpoint ep(
+        boost::asio::ip::address::from_string(config_.host, ec), config_.port);
+    if (ec) {
+      LOG_ERROR("[redis] bad address {}: {}", config_.host, ec.message());
+      return;
+    }
+    auto self = shared_from_this();
+    socket_.async_connect(
+        ep, boost::asio::bind_executor(strand_, [this, self](boost::system::error_code ec) {
+          if (stopped_)
+            return;
+          if (ec) {
+            LOG_ERROR("[redis] connect {}:{} failed: {}", config_.host, config_.port,
+                      ec.message());
+            schedule_reconnect();
+            return;
+          }
+          LOG_INFO("[redis] connected {}:{}", config_.host, config_.port);
+          socket_.set_option(boost::asio::ip::tcp::no_delay(true), ec);
+          backoff_ = config_.reconnect_initial;
+          reader_ = RespReader(config_.read_buffer_size);
+          connected_.store(true, std::memory_order_relaxed);
+          send_handshake();
+          do_read();
+        }));
+  }
+
+  // AUTH / HELLO / SUBSCRIBE / PSUBSCRIBE 拼成一次写出，回复与确认都在读循环中处理
+  void send_handshake() {
+    out_.clear();
+    if (!config_.password.empty())
+      append_command({"AUTH", config_.password});
+    if (config_.resp3)
+      append_command({"HELLO", "3"});
+    if (!config_.channels.empty()) {
+      std::vector<std::string_view> args{"SUBSCRIBE"};
+      for (const auto &c : config_.channels)
+        args.push_back(c.first);
+      append_command(args);
+    }
+    if (!config_.patterns.empty()) {
+      std::vector<std::string_view> args{"PSUBSCRIBE"};
+      for (const auto &p : config_.patterns)
+        args.push_back(p.first);
+      append_command(args);
+    }
+    if (out_.empty())
+      return;
+    auto self = shared_from_this();
+    boost::asio::async_write(
+        socket_, boost::asio::buffer(out_),
+        boost::asio::bind_executor(strand_, [this, self](boost::system::error_code ec,
+                                                         std::size_t) {
+          if (ec)
+            handle_error("Write error", ec);
+        }));
+  }
+
+  void append_command(const std::vector<std::string_view> &args) {
+    out_ += '*';
+    out_ += std::to_string(args.size());
+    out_ += "\r\n";
+    for (std::string_view a : args) {
+      out_ += '$';
+      out_ += std::to_string(a.size());
+      out_ += "\r\n";
+      out_.append(a.data(), a.size());
+      out_ += "\r\n";
+    }
+  }
+
+  void do_read() {
+    auto space = reader_.prepare();
+    if (space.second == 0) {
+      handle_error("Push frame exceeds read buffer",
+                   boost::asio::error::message_size);
+      return;
+    }
+    auto self = shared_from_this();
+    socket_.async_read_some(
+        boost::asio::buffer(space.first, space.second),
+        boost::asio::bind_executor(
+            strand_, make_alloc_handler(read_mem_, [this, self](boost::system::error_code ec,
+                                                                std::size_t n) {
+              if (stopped_)
+                return;
+              if (ec) {
+                handle_error("Read error", ec);
+                return;
+              }
+              long r = reader_.commit(n, [this](const RespFrame &f) { on_frame(f); });
+              flush_batch();
+              if (r < 0) {
+                handle_error("Protocol error", boost::asio::error::invalid_argument);
+                return;
+              }
+              do_read();
+            })));
+  }
+
+  void on_frame(const RespFrame &f) {
+    if (f.type == '-' || f.type == '!') {
+      LOG_ERROR("[redis] error reply: {}", f.str);
+      return;
+    }
+    if (!f.is_push_like() || f.count < 3)
+      return;  // AUTH / HELLO 等的回复
+    std::string_view kind = f.item(0);
+    if (kind == "message") {
+      dispatch(config_.channels, f.item(1), f.item(2));
+    } else if (kind == "pmessage" && f.count >= 4) {
+      dispatch(config_.patterns, f.item(1), f.item(3));
+    } else if (kind == "subscribe" || kind == "psubscribe") {
+      LOG_INFO("[redis] {} {} (total {})", kind, f.item(1), f.item(2));
+    }
+  }
+
+  void dispatch(const std::vector<std::pair<std::string, EventType>> &map,
+                std::string_view name, std::string_view payload) {
+    auto it = std::find_if(map.begin(), map.end(),
+                           [name](const auto &m) { return m.first == name; });
+    if (it == map.end()) {
+      stat_unmapped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    // 事件体按行下发给设备，与 on_redis_event(type, std::string) 一致附加换行；
+    // 事件体直接按最终长度构造，交给 make_shared_message 时只移动不复制
+    std::vector<uint8_t> body(payload.size() + 1);
+    std::memcpy(body.data(), payload.data(), payload.size());
+    body.back() = '\n';
+    batch_.emplace_back(it->second, make_shared_message(std::move(body)));
+    batch_bytes_ += payload.size();
+    if (batch_.size() >= config_.batch_max)
+      flush_batch();
+  }
+
+  void flush_batch() {
+    if (batch_.empty())
+      return;
+    if (auto mgr = manager_.lock())
+      mgr->on_redis_events(batch_);
+    stat_messages_.fetch_add(batch_.size(), std::memory_order_relaxed);
+    stat_bytes_.fetch_add(batch_bytes_, std::memory_order_relaxed);
+    stat_batches_.fetch_add(1, std::memory_order_relaxed);
+    batch_.clear();
+    batch_bytes_ = 0;
+  }
+
+  void handle_error(const char *what, const boost::system::error_code &ec) {
+    if (stopped_ || !connected_.exchange(false, std::memory_order_relaxed))
+      return;
+    LOG_ERROR("[redis] {}: {}", what, ec.message());
+    boost::system::error_code ignore;
+    socket_.close(ignore);
+    schedule_reconnect();
+  }
+
+  void schedule_reconnect() {
+    stat_reconnects_.fetch_add(1, std::memory_order_relaxed);
+    auto delay = backoff_;
+    backoff_ = std::min(backoff_ * 2, config_.reconnect_max);
+    timer_.expires_after(delay);
+    auto self = shared_from_this();
+    timer_.async_wait(boost::asio::bind_executor(strand_, [this, self](
+                                                              boost::system::error_code ec) {
+      if (!ec)
+        do_connect();
+    }));
+  }
+
+  boost::asio::io_context &io_;
+  RedisSubscriberConfig config_;
+  std::weak_ptr<ClientManager> manager_;
+  boost::asio::ip::tcp::socket socket_;
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+  boost::asio::steady_timer timer_;
+  RespReader reader_;
+  HandlerMemory<1> read_mem_;
+  std::string out_;      // 握手命令，写完前保持有效
+  EventBatch batch_;     // 本次读到的推送
+  std::size_t batch_bytes_ = 0;
+  std::chrono::milliseconds backoff_;
+  bool stopped_ = true;
+  std::atomic<bool> connected_{false};
+  std::atomic<uint64_t> stat_messages_{0};
+  std::atomic<uint64_t> stat_bytes_{0};
+  std::atomic<uint64_t> stat_batches_{0};
+  std::atomic<uint64_t> stat_unmapped_{0};
+  std::atomic<uint64_t> stat_reconnects_{0};
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+#include "readBuffer.h"
+
+// ============ RespFrame =============
+// 一个顶层 RESP2/RESP3 值。聚合类型（* 数组、> 推送、~ 集合）只展开第一层，
+// 前 kMaxItems 个元素中的字符串类（$ + - : 等）以 string_view 给出，
+// 嵌套聚合的元素只跳过不展开；所有 view 指向读缓冲区，只在回调期间有效
+struct RespFrame {
+  static constexpr std::size_t kMaxItems = 8;
+
+  char type = 0;          // 顶层类型字节
+  std::size_t count = 0;  // 聚合的元素个数；非聚合为 0
+  std::string_view str;   // 非聚合值的内容
+  std::string_view items[kMaxItems];
+
+  bool is_push_like() const { return type == '*' || type == '>'; }
+  std::string_view item(std::size_t i) const {
+    return i < count && i < kMaxItems ? items[i] : std::string_view();
+  }
+};
+
+// ============ RespReader =============
+// 基于 ReadBuffer 的 RESP 分帧器：socket 直接读入 prepare() 返回的空闲区，
+// commit(n, f) 就地解析出所有完整的顶层值并逐个交给 f(const RespFrame &)，
+// 不复制、不分配；残余的半个值留在缓冲区，下次读到后从头重新解析。
+// 单个值最长为缓冲区容量，超长时 prepare() 返回空闲长度 0；
+// 格式错误时 commit 返回 -1，调用方应断开连接。
+class RespReader {
+public:
+  explicit RespReader(std::size_t capacity = 1 << 20) : rb_(capacity) {}
+
+  std::pair<char *, std::size_t> prepare() { return rb_.prepare(); }
+
+  // 提交刚读入的 n 字节，返回本次交出的值个数，格式错误时返回 -1
+  template <typename F> long commit(std::size_t n, F &&f) {
+    rb_.produce(n);
+    buf_ = rb_.data();
+    tail_ = rb_.tail();
+    long frames = 0;
+    RespFrame frame;
+    while (rb_.head() < tail_) {
+      std::size_t pos = rb_.head();
+      int r = parse_top(pos, frame);
+      if (r < 0)
+        return -1;
+      if (r == 0)
+        break;
+      f(static_cast<const RespFrame &>(frame));
+      rb_.consume_to(pos);
+      ++frames;
+    }
+    return frames;
+  }
+
+  std::size_t pending_bytes() const { return rb_.pending_bytes(); }
+
+private:
+  // 1：完整；0：数据不足；-1：格式错误
+  int parse_top(std::size_t &pos, RespFrame &out) {
+    while (buf_[pos] == '|') {  // 顶层属性：跳过，交出紧随的值
+      int r = skip_aggregate(pos, 0);
+      if (r <= 0)
+        return r;
+      if (pos >= tail_)
+        return 0;
+    }
+    out.type = buf_[pos];
+    out.count = 0;
+    out.str = std::string_view();
+    int64_t n;
+    if (is_aggregate(out.type)) {
+      int r = read_header(pos, n);
+      if (r <= 0)
+        return r;
+      if (n < 0)  // RESP2 空数组
+        return 1;
+      std::size_t count = static_cast<std::size_t>(n) * (out.type == '%' ? 2 : 1);
+      out.count = count;
+      for (std::size_t i = 0; i < count; ++i) {
+        std::string_view v;
+        r = parse_value(pos, v, 0);
+        if (r <= 0)
+          return r;
+        if (i < RespFrame::kMaxItems)
+          out.items[i] = v;
+      }
+      return 1;
+    }
+    return parse_value(pos, out.str, 0);
+  }
+
+  // 解析任意一个值；字符串类写入 v，聚合类递归跳过
+  int parse_value(std::size_t &pos, std::string_view &v, int depth) {
+    if (pos >= tail_)
+      return 0;
+    if (depth > kMaxDepth)
+      return -1;
+    char t = buf_[pos];
+    if (t == '|') {  // RESP3 属性：跳过后再解析紧随的值
+      int r = skip_aggregate(pos, depth);
+      return r <= 0 ? r : parse_value(pos, v, depth);
+    }
+    if (is_aggregate(t)) {
+      v = std::string_view();
+      return skip_aggregate(pos, depth);
+    }
+    switch (t) {
+    case '$':
+    case '!':
+    case '=': {  // 带长度的字符串
+      int64_t len;
+      int r = read_header(pos, len);
+      if (r <= 0)
+        return r;
+      if (len < 0) {  // RESP2 空值
+        v = std::string_view();
+        return 1;
+      }
+      if (tail_ - pos < static_cast<std::size_t>(len) + 2)
+        return 0;
+      if (buf_[pos + len] != '\r' || buf_[pos + len + 1] != '\n')
+        return -1;
+      v = std::string_view(buf_ + pos, static_cast<std::size_t>(len));
+      pos += static_cast<std::size_t>(len) + 2;
+      return 1;
+    }
+    case '+':
+    case '-':
+    case ':':
+    case '_':
+    case '#':
+    case ',':
+    case '(': {  // 单行
+      std::size_t end;
+      int r = find_crlf(pos + 1, end);
+      if (r <= 0)
+        return r;
+      v = std::string_view(buf_ + pos + 1, end - pos - 1);
+      pos = end + 2;
+      return 1;
+    }
+    default:
+      return -1;
+    }
+  }
+
+  int skip_aggregate(std::size_t &pos, int depth) {
+    char t = buf_[pos];
+    int64_t n;
+    int r = read_header(pos, n);
+    if (r <= 0 || n < 0)
+      return r;
+    std::size_t count = static_cast<std::size_t>(n) * (t == '%' || t == '|' ? 2 : 1);
+    std::string_view ignored;
+    for (std::size_t i = 0; i < count; ++i) {
+      r = parse_value(pos, ignored, depth + 1);
+      if (r <= 0)
+        return r;
+    }
+    return 1;
+  }
+
+  // 读 "<类型><十进制>\r\n"，pos 移到其后
+  int read_header(std::size_t &pos, int64_t &n) {
+    std::size_t end;
+    int r = find_crlf(pos + 1, end);
+    if (r <= 0)
+      return r;
+    const char *p = buf_ + pos + 1;
+    const char *e = buf_ + end;
+    bool neg = p < e && *p == '-';
+    if (neg)
+      ++p;
+    if (p == e)
+      return -1;
+    n = 0;
+    for (; p < e; ++p) {
+      if (*p < '0' || *p > '9' || n > (INT64_MAX - 9) / 10)
+        return -1;
+      n = n * 10 + (*p - '0');
+    }
+    if (neg)
+      n = -n;
+    pos = end + 2;
+    return 1;
+  }
+
+  int find_crlf(std::size_t from, std::size_t &end) const {
+    while (from < tail_) {
+      const void *hit = std::memchr(buf_ + from, '\r', tail_ - from);
+      if (!hit)
+        return 0;
+      end = static_cast<const char *>(hit) - buf_;
+      if (end + 1 >= tail_)
+        return 0;
+      if (buf_[end + 1] == '\n')
+        return 1;
+      from = end + 1;
+    }
+    return 0;
+  }
+
+  static bool is_aggregate(char t) {
+    return t == '*' || t == '>' || t == '~' || t == '%' || t == '|';
+  }
+
+  static constexpr int kMaxDepth = 16;
+
+  ReadBuffer rb_;
+  // 本次 commit 期间 rb_ 的数据起点与末尾，供解析使用
+  const char *buf_ = nullptr;
+  std::size_t tail_ = 0;
+};
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ============ SlotHandle =============
+// 稠密整数句柄：index 为槽位下标，gen 为槽位的代数。
+// 槽位释放时代数加一，旧句柄随之失效，不会误指向复用该槽位的新对象。
+struct SlotHandle {
+  uint32_t index = 0;
+  uint32_t gen = 0;  // 0 表示无效
+
+  bool valid() const { return gen != 0; }
+  uint64_t value() const { return (static_cast<uint64_t>(gen) << 32) | index; }
+
+  bool operator==(const SlotHandle &o) const {
+    return index == o.index && gen == o.gen;
+  }
+  bool operator!=(const SlotHandle &o) const { return !(*this == o); }
+};
+
+// ============ SlotTable =============
+// 句柄 -> 值 的并发表，V 需可判空（如 shared_ptr），空值视为不存在：
+//   - 槽位按页（1024 个）分配，页分配后不再移动；查找就是
+//     pages_[index >> 10][index & 1023] 加一次代数比较，不哈希、不比较字符串；
+//   - 每个槽位一把自旋锁，只保护该槽位的值，不同句柄之间互不干扰；
+//   - allocate / release 属于冷路径，一把互斥锁保护空闲链表。
+template <typename V> class SlotTable {
+public:
+  using Handle = SlotHandle;
+
+  SlotTable() {
+    for (auto &p : pages_)
+      p.store(nullptr, std::memory_order_relaxed);
+  }
+
+  ~SlotTable() {
+    for (auto &p : pages_)
+      delete[] p.load(std::memory_order_relaxed);
+  }
+
+  SlotTable(const SlotTable &) = delete;
+  SlotTable &operator=(const SlotTable &) = delete;
+
+  // 取一个空槽位，值为空
+  Handle allocate() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    uint32_t idx;
+    if (!free_.empty()) {
+      idx = free_.back();
+      free_.pop_back();
+    } else {
+      idx = static_cast<uint32_t>(next_.load(std::memory_order_relaxed));
+      if ((idx >> kPageBits) >= kMaxPages)
+        throw std::length_error("SlotTable: out of slots");
+      if ((idx & kPageMask) == 0)
+        pages_[idx >> kPageBits].store(new Slot[kPageSize],
+                                       std::memory_order_release);
+      next_.store(idx + 1, std::memory_order_release);
+    }
+    ++size_;
+    Slot &s = pages_[idx >> kPageBits].load(std::memory_order_relaxed)[idx & kPageMask];
+    SpinGuard g(s.lock);
+    return Handle{idx, s.gen};
+  }
+
+  // 清空并归还槽位，句柄失效；句柄已失效时返回 false。旧值在锁外析构
+  bool release(Handle h) {
+    V dead;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      Slot *s = slot_of(h);
+      if (!s)
+        return false;
+      {
+        SpinGuard g(s->lock);
+        if (s->gen != h.gen)
+          return false;
+        std::swap(dead, s->value);
+        s->gen = h.gen + 1 ? h.gen + 1 : 1;
+      }
+      free_.push_back(h.index);
+      --size_;
+    }
+    return true;
+  }
+
+  // 替换句柄上的值，旧值写入 old（可为空指针）；句柄已失效时返回 false
+  bool exchange(Handle h, V value, V *old = nullptr) {
+    Slot *s = slot_of(h);
+    if (!s)
+      return false;
+    {
+      SpinGuard g(s->lock);
+      if (s->gen != h.gen)
+        return false;
+      std::swap(value, s->value);
+    }
+    if (old)
+      *old = std::move(value);
+    return true;
+  }
+
+  // 当前值满足 pred 时才替换，用于"只清掉自己放进去的那个值"；
+  // 句柄已失效或 pred 为假时返回 false。pred 在槽位锁内调用，应尽量短
+  template <typename P>
+  bool exchange_if(Handle h, P &&pred, V value, V *old = nullptr) {
+    Slot *s = slot_of(h);
+    if (!s)
+      return false;
+    {
+      SpinGuard g(s->lock);
+      if (s->gen != h.gen || !pred(static_cast<const V &>(s->value)))
+        return false;
+      std::swap(value, s->value);
+    }
+    if (old)
+      *old = std::move(value);
+    return true;
+  }
+
+  // 拷贝出值（对 shared_ptr 来说是一次引用计数增加）
+  bool find(Handle h, V &out) const {
+    return visit(h, [&out](const V &v) { out = v; });
+  }
+
+  // 在槽位锁内对值调用 f，避免拷贝；f 应尽量短，且不得再访问本表
+  template <typename F> bool visit(Handle h, F &&f) const {
+    Slot *s = slot_of(h);
+    if (!s)
+      return false;
+    SpinGuard g(s->lock);
+    if (s->gen != h.gen || !s->value)
+      return false;
+    f(static_cast<const V &>(s->value));
+    return true;
+  }
+
+  // f(Handle, const V &)，跳过空槽位；逐个槽位加锁，f 内不得再访问本表
+  template <typename F> void for_each(F &&f) const {
+    std::size_t n = next_.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < n; ++i) {
+      Slot &s = pages_[i >> kPageBits].load(std::memory_order_acquire)[i & kPageMask];
+      SpinGuard g(s.lock);
+      if (s.value)
+        f(Handle{static_cast<uint32_t>(i), s.gen}, static_cast<const V &>(s.value));
+    }
+  }
+
+  // 已分配的句柄数（含值为空的）
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return size_;
+  }
+
+private:
+  static constexpr unsigned kPageBits = 10;
+  static constexpr std::size_t kPageSize = std::size_t(1) << kPageBits;
+  static constexpr std::size_t kPageMask = kPageSize - 1;
+  static constexpr std::size_t kMaxPages = 1024;  // 最多约 100 万个句柄
+
+  struct Slot {
+    mutable std::atomic<bool> lock{false};
+    uint32_t gen = 1;  // 受 lock 保护
+    V value;           // 受 lock 保护
+  };
+
+  struct SpinGuard {
+    explicit SpinGuard(std::atomic<bool> &f) : flag(f) {
+      while (flag.exchange(true, std::memory_order_acquire))
+        while (flag.load(std::memory_order_relaxed))
+          std::this_thread::yield();
+    }
+    ~SpinGuard() { flag.store(false, std::memory_order_release); }
+    std::atomic<bool> &flag;
+  };
+
+  Slot *slot_of(Handle h) const {
+    if (!h.valid() || h.index >= next_.load(std::memory_order_acquire))
+      return nullptr;
+    return &pages_[h.index >> kPageBits].load(std::memory_order_acquire)[h.index & kPageMask];
+  }
+
+  std::atomic<Slot *> pages_[kMaxPages];
+  std::atomic<std::size_t> next_{0};  // 已初始化的槽位数，只增不减
+  mutable std::mutex mtx_;
+  std::vector<uint32_t> free_;  // 受 mtx_ 保护
+  std::size_t size_ = 0;        // 受 mtx_ 保护
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// ============ 溢出统计 ============
+struct SpillStats {
+  std::size_t pending = 0;        // 磁盘上尚未取回的消息数
+  std::size_t pending_bytes = 0;  // 对应的消息体字节数
+  std::size_t segments = 0;       // 当前段文件数
+  uint64_t spilled = 0;           // 累计写入
+  uint64_t replayed = 0;          // 累计取回
+  uint64_t rejected = 0;          // 超出容量或单条超过段长而未写入
+};
+
+// ============ SpillStore =============
+// 单个端点的磁盘溢出队列：固定长度的段文件组成的 FIFO，段通过 mmap 读写。
+//   - 记录为 [u32 长度][u8 标签][3 字节填充][消息体]，写入即 memcpy 到映射区；
+//   - 只有写入段与读取段处于映射状态，写满的中间段解除映射、交给页缓存回写，
+//     所以长时间断线时内存占用只有两个段，积压量只受 max_bytes 限制；
+//   - 读取段读完即删除；读写同段且全部读完时回到段首重用，不再建新文件；
+//   - read() 一次加锁连续取出多条，按写入顺序交给回调。
+// 不跨进程重启恢复：构造时清除同名的残留段，析构时删除全部段。
+// 所有接口线程安全，内部一把互斥锁；empty() 无锁。
+class SpillStore {
+public:
+  SpillStore(const std::string &dir, const std::string &name,
+             std::size_t segment_bytes, std::size_t max_bytes)
+      : dir_(dir), prefix_(sanitize(name) + "."),
+        seg_bytes_(std::max<std::size_t>(segment_bytes, 4096)),
+        max_segments_(std::max<std::size_t>(max_bytes / seg_bytes_, 2)) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    for (auto it = std::filesystem::directory_iterator(dir_, ec);
+         !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+      std::string f = it->path().filename().string();
+      if (f.compare(0, prefix_.size(), prefix_) == 0 &&
+          f.size() > 6 && f.compare(f.size() - 6, 6, ".spill") == 0)
+        std::filesystem::remove(it->path(), ec);
+    }
+  }
+
+  ~SpillStore() {
+    for (auto &s : segs_) {
+      unmap(s);
+      ::unlink(path(s.seq).c_str());
+    }
+  }
+
+  SpillStore(const SpillStore &) = delete;
+  SpillStore &operator=(const SpillStore &) = delete;
+
+  bool empty() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+  // 追加一条；was_empty 非空时返回追加前是否为空。容量不足或 IO 失败时返回 false
+  bool append(uint8_t tag, const void *data, std::size_t len,
+              bool *was_empty = nullptr) {
+    std::size_t need = kHeader + len;
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (need > seg_bytes_ || len > UINT32_MAX)
+      return reject();
+    if (segs_.empty() || seg_bytes_ - segs_.back().end < need) {
+      if (segs_.size() >= max_segments_ || !add_segment())
+        return reject();
+    }
+    Segment &s = segs_.back();
+    if (!s.base && !map(s))
+      return reject();
+    char *p = s.base + s.end;
+    uint32_t n = static_cast<uint32_t>(len);
+    std::memcpy(p, &n, sizeof(n));
+    p[4] = static_cast<char>(tag);
+    std::memcpy(p + kHeader, data, len);
+    s.end += need;
+    if (was_empty)
+      *was_empty = pending_.load(std::memory_order_relaxed) == 0;
+    pending_bytes_ += len;
+    ++spilled_;
+    pending_.fetch_add(1, std::memory_order_release);
+    return true;
+  }
+
+  // 按写入顺序取出至多 max_records 条 / 约 max_bytes 字节（至少一条），
+  // 对每条调用 f(tag, const uint8_t *data, len)，返回条数。data 只在回调期间有效
+  template <typename F>
+  std::size_t read(std::size_t max_records, std::size_t max_bytes, F &&f) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::size_t n = 0, bytes = 0;
+    while (n < max_records && !segs_.empty()) {
+      Segment &s = segs_.front();
+      if (s.pos == s.end) {
+        if (segs_.size() == 1) {
+          s.pos = s.end = 0;  // 唯一的段已读完，回到段首重用
+          break;
+        }
+        unmap(s);
+        ::unlink(path(s.seq).c_str());
+        segs_.pop_front();
+        continue;
+      }
+      if (!s.base && !map(s))
+        break;
+      const char *p = s.base + s.pos;
+      uint32_t len;
+      std::memcpy(&len, p, sizeof(len));
+      if (n > 0 && bytes + len > max_bytes)
+        break;
+      f(static_cast<uint8_t>(p[4]), reinterpret_cast<const uint8_t *>(p + kHeader),
+        static_cast<std::size_t>(len));
+      s.pos += kHeader + len;
+      bytes += len;
+      pending_bytes_ -= len;
+      ++replayed_;
+      ++n;
+      pending_.fetch_sub(1, std::memory_order_release);
+    }
+    return n;
+  }
+
+  SpillStats stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    SpillStats st;
+    st.pending = pending_.load(std::memory_order_relaxed);
+    st.pending_bytes = pending_bytes_;
+    st.segments = segs_.size();
+    st.spilled = spilled_;
+    st.replayed = replayed_;
+    st.rejected = rejected_;
+    return st;
+  }
+
+private:
+  static constexpr std::size_t kHeader = 8;
+
+  struct Segment {
+    uint64_t seq;
+    std::size_t pos = 0;  // 读位置
+    std::size_t end = 0;  // 写位置
+    char *base = nullptr;
+  };
+
+  static std::string sanitize(const std::string &name) {
+    std::string out = name;
+    for (char &c : out)
+      if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_')
+        c = '_';
+    return out;
+  }
+
+  std::string path(uint64_t seq) const {
+    return dir_ + "/" + prefix_ + std::to_string(seq) + ".spill";
+  }
+
+  bool reject() {
+    ++rejected_;
+    return false;
+  }
+
+  // 需持有 mtx_：新建写入段，之前的写入段若不是读取段则解除映射
+  bool add_segment() {
+    Segment s{next_seq_++};
+    int fd = ::open(path(s.seq).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+      return false;
+    bool ok = ::ftruncate(fd, static_cast<off_t>(seg_bytes_)) == 0;
+    ::close(fd);
+    if (!ok) {
+      ::unlink(path(s.seq).c_str());
+      return false;
+    }
+    if (segs_.size() > 1)
+      unmap(segs_.back());
+    segs_.push_back(s);
+    return true;
+  }
+
+  bool map(Segment &s) {
+    int fd = ::open(path(s.seq).c_str(), O_RDWR);
+    if (fd < 0)
+      return false;
+    void *p = ::mmap(nullptr, seg_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+      return false;
+    s.base = static_cast<char *>(p);
+    return true;
+  }
+
+  void unmap(Segment &s) {
+    if (s.base) {
+      ::munmap(s.base, seg_bytes_);
+      s.base = nullptr;
+    }
+  }
+
+  std::string dir_;
+  std::string prefix_;
+  std::size_t seg_bytes_;
+  std::size_t max_segments_;
+  mutable std::mutex mtx_;
+  std::deque<Segment> segs_;  // 队首为读取段，队尾为写入段
+  uint64_t next_seq_ = 0;
+  std::atomic<std::size_t> pending_{0};
+  std::size_t pending_bytes_ = 0;
+  uint64_t spilled_ = 0;
+  uint64_t replayed_ = 0;
+  uint64_t rejected_ = 0;
+};
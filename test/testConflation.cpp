@@ -0,0 +1,78 @@
+// 最新值合并测试：慢速设备上同 key 尚未下发的事件被新值覆盖，每个 key 只收到最新值；
+// 未开启合并的类型逐条下发；关闭合并后恢复逐条下发
+//
+// 编译: g++ -std=c++17 -g -O1 -fsanitize=address,undefined -I.. testConflation.cpp -o testConflation -lpthread
+// 运行: ./testConflation    （全部通过时退出码为 0）
+#include "testUtil.h"
+
+using namespace testutil;
+
+// "key=value" -> key
+static std::string_view key_of(std::string_view event) {
+  std::size_t eq = event.find('=');
+  return eq == std::string_view::npos ? std::string_view() : event.substr(0, eq);
+}
+
+static std::vector<std::string> with_prefix(const FakeDevice &dev, const std::string &prefix) {
+  std::vector<std::string> out;
+  for (const auto &l : dev.lines())
+    if (l.compare(0, prefix.size(), prefix) == 0)
+      out.push_back(l);
+  return out;
+}
+
+static void latest_value(boost::asio::io_context &io) {
+  std::printf("pending updates collapse to the latest value per key\n");
+  FakeDevice dev(true, 200ms);
+  auto mgr = std::make_shared<ClientManager>(io);
+  mgr->set_conflation(EventType::EVENT_B, key_of);
+  ConnInfo info = device_info(dev);
+  info.write_mode = WriteMode::PING_PONG;
+  info.event_types = {EventType::EVENT_A, EventType::EVENT_B};
+  info.event_batch_delay = 0ms;
+  ConnHandle h = mgr->add_connection(info);
+  check(wait_online(*mgr, h), "connected");
+
+  // 第一条等待慢速应答期间，其余事件都积压在连接上
+  mgr->send_message(h, make_shared_message(std::string("first\n")));
+  wait_until([&] { return dev.count("first") == 1; });
+  const int updates = 50;
+  std::size_t conflated = 0;
+  for (int i = 1; i <= updates; ++i) {
+    conflated += mgr->on_redis_event(EventType::EVENT_B, "k1=" + std::to_string(i)).conflated;
+    conflated += mgr->on_redis_event(EventType::EVENT_B, "k2=" + std::to_string(i)).conflated;
+  }
+  for (int i = 0; i < 3; ++i)
+    mgr->on_redis_event(EventType::EVENT_A, "a=" + std::to_string(i));
+  check(conflated == 2 * (updates - 1), "every update after the first per key conflated");
+  QueueStats qs;
+  mgr->queue_stats(h, qs);
+  check(qs.conflated == conflated, "queue stats count conflated events");
+
+  check(wait_until([&] { return with_prefix(dev, "a=").size() == 3 &&
+                                with_prefix(dev, "k").size() >= 2; }, 5000ms),
+        "backlog written");
+  std::this_thread::sleep_for(300ms);
+  auto k = with_prefix(dev, "k");
+  std::string last = "=" + std::to_string(updates);
+  check(k.size() == 2 && k[0] == "k1" + last && k[1] == "k2" + last,
+        "each key delivered once with its latest value");
+  auto a = with_prefix(dev, "a=");
+  check(a.size() == 3 && a[0] == "a=0" && a[1] == "a=1" && a[2] == "a=2",
+        "non-conflated type delivered one by one, in order");
+
+  mgr->set_conflation(EventType::EVENT_B, nullptr);
+  EventRouteResult r;
+  for (int i = 0; i < 3; ++i)
+    r = mgr->on_redis_event(EventType::EVENT_B, "k3=" + std::to_string(i));
+  check(r.conflated == 0, "no conflation after it is turned off");
+  check(wait_until([&] { return with_prefix(dev, "k3=").size() == 3; }, 5000ms),
+        "every update delivered after it is turned off");
+}
+
+int main() {
+  std::setvbuf(stdout, nullptr, _IOLBF, 0);
+  IoRunner runner;
+  latest_value(runner.io());
+  return summary();
+}
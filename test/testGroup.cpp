@@ -0,0 +1,135 @@
+// 端点组测试：负载最轻的成员优先、写磁盘的成员排后且不重复投递、
+// 已关闭的成员拒收使发送改投下一个、成员断开后发送立即只在其余成员间分配
+//
+// 编译: g++ -std=c++17 -g -O1 -fsanitize=address,undefined -I.. testGroup.cpp -o testGroup -lpthread
+// 运行: ./testGroup    （全部通过时退出码为 0）
+#include "testUtil.h"
+
+using namespace testutil;
+
+struct Member {
+  ConnHandle h;
+  FakeDevice *dev;
+};
+
+// 已写出 + 仍在队列 + 磁盘上待补发，是该成员名下的消息总数
+static std::size_t held(ClientManager &mgr, const Member &m) {
+  QueueStats qs;
+  SpillStats ss;
+  mgr.queue_stats(m.h, qs);
+  mgr.spill_stats(m.h, ss);
+  return m.dev->line_count() + qs.depth + ss.pending;
+}
+
+// 成员 A 的设备不回复且高水位为 2：队列满后写入磁盘，应排到 B 之后，
+// 且写入 A 磁盘的那一条不能再投给 B
+static void spilling_member(boost::asio::io_context &io) {
+  std::printf("spilling member ranks last and keeps its message\n");
+  FakeDevice dev_a(false), dev_b(false);
+  auto mgr = std::make_shared<ClientManager>(io);
+  ConnInfo a = device_info(dev_a);
+  a.group = "g";
+  a.high_watermark = 2;
+  a.low_watermark = 1;
+  a.spill_dir = "/tmp/testGroup-spill";
+  ConnInfo b = device_info(dev_b);
+  b.group = "g";
+  Member ma{mgr->add_connection(a), &dev_a};
+  Member mb{mgr->add_connection(b), &dev_b};
+  check(wait_online(*mgr, ma.h) && wait_online(*mgr, mb.h), "both members online");
+  GroupHandle g = mgr->find_group("g");
+
+  const std::size_t total = 20;
+  std::size_t spilled = 0, other = 0;
+  for (std::size_t i = 0; i < total; ++i) {
+    SendResult r = mgr->send_to_group(g, make_shared_message("m" + std::to_string(i) + "\n"));
+    spilled += r == SendResult::SPILLED;
+    other += r != SendResult::OK && r != SendResult::SPILLED;
+    std::this_thread::sleep_for(5ms);
+  }
+  check(other == 0, "every send accepted");
+  check(spilled > 0, "some sends spilled");
+  wait_until([&] { return held(*mgr, ma) + held(*mgr, mb) >= total; }, 500ms);
+  std::this_thread::sleep_for(100ms);
+  check(held(*mgr, ma) + held(*mgr, mb) == total, "every message held by exactly one member");
+  SpillStats ss;
+  mgr->spill_stats(ma.h, ss);
+  check(ss.spilled == spilled, "spilled sends stayed with the spilling member");
+  QueueStats qs;
+  mgr->queue_stats(ma.h, qs);
+  check(qs.backpressured == (ss.pending > 0), "spilling member reports backpressure");
+  GroupStats gs;
+  mgr->group_stats(g, gs);
+  check(gs.sent == total && gs.rerouted == 0 && gs.failed == 0, "no reroute after a spill");
+}
+
+// 已关闭、尚未从组中摘除的连接拒收，发送方据此改投
+static void closed_connection_refuses(boost::asio::io_context &io) {
+  std::printf("closed connection refuses new messages\n");
+  ConnInfo info;
+  info.ip = "127.0.0.1";
+  info.port = 1;
+  auto conn = Connection::create(io, "closed", info, TimingWheel::create(io));
+  check(conn->push_message(make_shared_message(std::string("a\n"))) == SendResult::OK,
+        "open connection accepts");
+  conn->close(false, false);
+  wait_until([&] {
+    return conn->push_message(make_shared_message(std::string("b\n"))) ==
+           SendResult::NO_CONNECTION;
+  }, 500ms);
+  check(conn->push_message(make_shared_message(std::string("c\n"))) ==
+            SendResult::NO_CONNECTION,
+        "push_message after close returns NO_CONNECTION");
+  RequestTicket t = conn->push_request(make_shared_message(std::string("d\n")), 100ms,
+                                       [](RequestStatus, std::string_view) {});
+  check(!t.accepted() && t.result == SendResult::NO_CONNECTION,
+        "push_request after close returns NO_CONNECTION");
+  check(conn->enqueue_event(EventMsg{make_shared_message(std::string("e\n"))}) ==
+            SendResult::NO_CONNECTION,
+        "enqueue_event after close returns NO_CONNECTION");
+}
+
+// 成员掉线（不重连）后，组内发送全部落到另一个成员
+static void failover_on_disconnect(boost::asio::io_context &io) {
+  std::printf("failover when a member drops\n");
+  FakeDevice dev_a, dev_b;
+  auto mgr = std::make_shared<ClientManager>(io);
+  ConnInfo a = device_info(dev_a);
+  a.group = "g";
+  a.write_mode = WriteMode::PIPELINED;
+  a.auto_reconnect = false;
+  ConnInfo b = a;
+  b.port = dev_b.port();
+  Member ma{mgr->add_connection(a), &dev_a};
+  Member mb{mgr->add_connection(b), &dev_b};
+  check(wait_online(*mgr, ma.h) && wait_online(*mgr, mb.h), "both members online");
+  GroupHandle g = mgr->find_group("g");
+  for (int i = 0; i < 10; ++i)
+    mgr->send_to_group(g, make_shared_message(std::string("before\n")));
+  check(wait_until([&] { return dev_a.line_count() + dev_b.line_count() == 10; }),
+        "sends spread before the drop");
+  check(dev_a.line_count() > 0 && dev_b.line_count() > 0, "both members used");
+
+  // 空闲连接不读，掉线由心跳写出时发现
+  mgr->start_send_loop();
+  dev_a.drop_all();
+  GroupStats gs;
+  check(wait_until([&] { return mgr->group_stats(g, gs) && gs.online == 1; }, 5000ms),
+        "dropped member leaves the group");
+  int ok = 0;
+  for (int i = 0; i < 10; ++i)
+    ok += mgr->send_to_group(g, make_shared_message(std::string("after\n"))) ==
+          SendResult::OK;
+  check(ok == 10, "sends after the drop accepted");
+  check(wait_until([&] { return dev_b.count("after") == 10; }),
+        "remaining member receives every send");
+}
+
+int main() {
+  std::setvbuf(stdout, nullptr, _IOLBF, 0);
+  IoRunner runner;
+  spilling_member(runner.io());
+  closed_connection_refuses(runner.io());
+  failover_on_disconnect(runner.io());
+  return summary();
+}
@@ -0,0 +1,86 @@
+// 连接句柄测试：删除端点后句柄立即失效，槽位被新端点复用时旧句柄不会发到新连接；
+// 连接被重建后，旧连接迟到的断线回调不得清掉新连接或再次拨号
+//
+// 编译: g++ -std=c++17 -g -O1 -fsanitize=address,undefined -I.. testHandles.cpp -o testHandles -lpthread
+// 运行: ./testHandles    （全部通过时退出码为 0）
+#include "testUtil.h"
+
+using namespace testutil;
+
+// 删除 A 后添加 B：B 复用 A 的槽位，代数不同
+static void slot_reuse(boost::asio::io_context &io) {
+  std::printf("stale handle after slot reuse\n");
+  FakeDevice dev_a, dev_b;
+  auto mgr = std::make_shared<ClientManager>(io);
+  ConnInfo a = device_info(dev_a);
+  ConnInfo b = device_info(dev_b);
+  ConnHandle ha = mgr->add_connection(a);
+  check(wait_online(*mgr, ha), "A online");
+  std::string key_a = "127.0.0.1:" + std::to_string(dev_a.port());
+  check(mgr->find_handle(key_a).value() == ha.value(), "key resolves to A's handle");
+
+  mgr->reload_connections({});  // 从配置中删除 A
+  check(!mgr->find_handle(key_a).valid(), "removed key no longer resolves");
+  ConnHandle hb = mgr->add_connection(b);
+  check(hb.index == ha.index && hb.gen != ha.gen, "B reuses the slot with a new generation");
+  check(wait_online(*mgr, hb), "B online");
+
+  check(mgr->send_message(ha, make_shared_message(std::string("stale\n"))) ==
+            SendResult::NO_CONNECTION,
+        "send on the stale handle fails");
+  WriteStats ws;
+  check(!mgr->write_stats(ha, ws), "stats on the stale handle fail");
+  check(mgr->send_message(hb, make_shared_message(std::string("fresh\n"))) == SendResult::OK,
+        "send on the new handle succeeds");
+  check(wait_until([&] { return dev_b.count("fresh") == 1; }), "new handle reaches B");
+  std::this_thread::sleep_for(50ms);
+  check(dev_b.count("stale") == 0 && dev_a.count("stale") == 0, "stale send reached nobody");
+}
+
+// 反复：设备断开旧连接的同时热重载重建连接。旧连接的断线回调与重建先后不定，
+// 无论谁先，每轮都应恰好多一次建连，且新连接保持在线、保留订阅
+static void late_disconnect_after_reopen(boost::asio::io_context &io) {
+  std::printf("late disconnect from a replaced connection\n");
+  FakeDevice dev(false);
+  auto mgr = std::make_shared<ClientManager>(io);
+  ReconnectPolicy policy;
+  policy.initial = 20ms;
+  policy.max = 20ms;
+  mgr->set_reconnect_policy(policy);
+  ConnInfo info = device_info(dev);
+  info.write_mode = WriteMode::PIPELINED;
+  // 探测事件不攒批：测试结束停止 io_context 时，时间轮上不留持有连接的定时器
+  info.event_batch_delay = 0ms;
+  ConnHandle h = mgr->add_connection(info);
+  check(wait_online(*mgr, h), "connected");
+
+  const int rounds = 20;
+  int extra_dials = 0, lost = 0, unsubscribed = 0;
+  for (int i = 0; i < rounds; ++i) {
+    // 一条未应答的消息让连接处于读状态，对端断开能立即被发现
+    mgr->send_message(h, make_shared_message("r" + std::to_string(i) + "\n"));
+    std::string line = "r" + std::to_string(i);
+    wait_until([&] { return dev.count(line) == 1; });
+    int accepted = dev.accepted();
+    dev.drop_all();
+    info.max_inflight = info.max_inflight == 64 ? 32 : 64;  // 链路参数变化：重建
+    mgr->reload_connections({info});
+    wait_until([&] { return dev.accepted() > accepted; });
+    std::this_thread::sleep_for(100ms);  // 让迟到的回调与可能的多余拨号落地
+    extra_dials += dev.accepted() != accepted + 1;
+    WriteStats ws;
+    lost += !mgr->write_stats(h, ws);
+    unsubscribed += mgr->on_redis_event(EventType::EVENT_A, "probe").subscribers != 1;
+  }
+  check(extra_dials == 0, "exactly one dial per rebuild");
+  check(lost == 0, "new connection stays in the slot");
+  check(unsubscribed == 0, "new connection keeps its subscription");
+}
+
+int main() {
+  std::setvbuf(stdout, nullptr, _IOLBF, 0);
+  IoRunner runner;
+  slot_reuse(runner.io());
+  late_disconnect_after_reopen(runner.io());
+  return summary();
+}
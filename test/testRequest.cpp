@@ -0,0 +1,139 @@
+// 请求/应答测试：按序与按 id 对应回复、截止时间、取消、id 重复、断线，
+// 每个被接收的请求的回调恰好执行一次
+//
+// 编译: g++ -std=c++17 -g -O1 -fsanitize=address,undefined -I.. testRequest.cpp -o testRequest -lpthread
+// 运行: ./testRequest    （全部通过时退出码为 0）
+#include <cstdlib>
+
+#include "testUtil.h"
+
+using namespace testutil;
+
+struct Outcome {
+  std::atomic<int> calls{0};
+  std::atomic<int> status{-1};
+  std::mutex mtx;
+  std::string reply;
+
+  bool done(RequestStatus st) const {
+    return calls.load() == 1 && status.load() == static_cast<int>(st);
+  }
+};
+
+static ReplyCallback record(const std::shared_ptr<Outcome> &o) {
+  return [o](RequestStatus st, std::string_view reply) {
+    {
+      std::lock_guard<std::mutex> lock(o->mtx);
+      o->reply = std::string(reply);
+    }
+    o->status.store(static_cast<int>(st));
+    o->calls.fetch_add(1);
+  };
+}
+
+static SharedMessage line(const std::string &s) { return make_shared_message(s + "\n"); }
+
+// "id=<十进制>" -> id
+static bool parse_id(std::string_view line, RequestId &id) {
+  if (line.compare(0, 3, "id=") != 0)
+    return false;
+  id = std::strtoull(std::string(line.substr(3)).c_str(), nullptr, 10);
+  return id != 0;
+}
+
+// 按发送顺序对应：迟到的回复不会串给后一个请求
+static void ordered(boost::asio::io_context &io) {
+  std::printf("ordered replies and deadlines\n");
+  FakeDevice dev(true, 150ms);
+  auto mgr = std::make_shared<ClientManager>(io);
+  ConnInfo info = device_info(dev);
+  info.write_mode = WriteMode::PIPELINED;
+  ConnHandle h = mgr->add_connection(info);
+  check(wait_online(*mgr, h), "connected");
+
+  auto late = std::make_shared<Outcome>();
+  auto ok = std::make_shared<Outcome>();
+  RequestTicket t1 = mgr->request(h, line("q1"), 50ms, record(late));
+  RequestTicket t2 = mgr->request(h, line("q2"), 2000ms, record(ok));
+  check(t1.accepted() && t2.accepted() && t1.id != t2.id, "requests accepted");
+  check(wait_until([&] { return late->calls.load() && ok->calls.load(); }),
+        "both requests completed");
+  std::this_thread::sleep_for(300ms);  // 让迟到的回复落地
+  check(late->done(RequestStatus::TIMEOUT), "short deadline ends TIMEOUT once");
+  check(ok->done(RequestStatus::OK) && ok->reply == "reply", "second request gets its reply");
+
+  RequestStats st;
+  mgr->request_stats(h, st);
+  check(st.outstanding == 0 && st.completed == 1 && st.timed_out == 1, "request stats");
+
+  RequestTicket none = mgr->request(ConnHandle{}, line("q"), 100ms, record(late));
+  check(!none.accepted() && none.result == SendResult::NO_CONNECTION,
+        "unknown handle is not accepted");
+}
+
+// 取消与断线：设备不回复
+static void cancel_and_disconnect(boost::asio::io_context &io) {
+  std::printf("cancel and disconnect\n");
+  FakeDevice dev(false);
+  auto mgr = std::make_shared<ClientManager>(io);
+  ConnInfo info = device_info(dev);
+  info.write_mode = WriteMode::PIPELINED;
+  info.auto_reconnect = false;
+  ConnHandle h = mgr->add_connection(info);
+  check(wait_online(*mgr, h), "connected");
+
+  auto cancelled = std::make_shared<Outcome>();
+  auto pending = std::make_shared<Outcome>();
+  RequestTicket t1 = mgr->request(h, line("c1"), 5000ms, record(cancelled));
+  RequestTicket t2 = mgr->request(h, line("c2"), 5000ms, record(pending));
+  check(t1.accepted() && t2.accepted(), "requests accepted");
+  check(mgr->cancel_request(h, t1.id), "cancel on a live connection");
+  check(wait_until([&] { return cancelled->calls.load() == 1; }), "cancel completes");
+  check(cancelled->done(RequestStatus::CANCELLED), "cancelled request ends CANCELLED");
+  mgr->cancel_request(h, t1.id);  // 已完成，无效果
+  std::this_thread::sleep_for(50ms);
+  check(cancelled->calls.load() == 1, "second cancel is a no-op");
+
+  check(wait_until([&] { return dev.line_count() == 2; }), "requests written");
+  dev.drop_all();
+  mgr->start_send_loop();  // 心跳写出时发现掉线
+  check(wait_until([&] { return pending->calls.load() == 1; }, 5000ms),
+        "outstanding request completes on disconnect");
+  check(pending->done(RequestStatus::DISCONNECTED), "ends DISCONNECTED");
+}
+
+// 按 id 对应：回复行带 id，重复的 id 与提取不到 id 的请求不发出
+static void correlated(boost::asio::io_context &io) {
+  std::printf("correlated replies\n");
+  FakeDevice dev(true, 100ms);
+  auto mgr = std::make_shared<ClientManager>(io);
+  ConnInfo info = device_info(dev);
+  info.write_mode = WriteMode::PIPELINED;
+  info.correlate = parse_id;
+  ConnHandle h = mgr->add_connection(info);
+  check(wait_online(*mgr, h), "connected");
+
+  auto a = std::make_shared<Outcome>();
+  auto dup = std::make_shared<Outcome>();
+  auto b = std::make_shared<Outcome>();
+  RequestTicket ta = mgr->request(h, line("id=7 first"), 2000ms, record(a));
+  RequestTicket td = mgr->request(h, line("id=7 again"), 2000ms, record(dup));
+  RequestTicket tb = mgr->request(h, line("id=9"), 2000ms, record(b));
+  check(ta.accepted() && ta.id == 7 && td.id == 7 && tb.id == 9, "ids taken from the message");
+  RequestTicket bad = mgr->request(h, line("no id"), 2000ms, record(b));
+  check(!bad.accepted() && bad.result == SendResult::REJECTED, "message without id rejected");
+  check(wait_until([&] { return a->calls.load() && dup->calls.load() && b->calls.load(); }),
+        "all requests completed");
+  check(a->done(RequestStatus::OK) && a->reply == "id=7 first", "id 7 gets its own reply");
+  check(dup->done(RequestStatus::DUPLICATE), "in-flight id reused ends DUPLICATE");
+  check(b->done(RequestStatus::OK) && b->reply == "id=9", "id 9 gets its own reply");
+}
+
+int main() {
+  std::setvbuf(stdout, nullptr, _IOLBF, 0);
+  IoRunner runner;
+  ordered(runner.io());
+  cancel_and_disconnect(runner.io());
+  correlated(runner.io());
+  return summary();
+}
@@ -0,0 +1,153 @@
+// 磁盘溢出测试：离线期间发出的消息与订阅的事件、断开时未获应答的消息都在重连后
+// 按原顺序补发，高水位以上写入磁盘的消息与内存队列交替时也不乱序；
+// 设备收到的序号不缺失、不倒序
+//
+// 编译: g++ -std=c++17 -g -O1 -fsanitize=address,undefined -I.. testSpill.cpp -o testSpill -lpthread
+// 运行: ./testSpill    （全部通过时退出码为 0）
+#include <set>
+
+#include "testUtil.h"
+
+using namespace testutil;
+
+// 设备收到的形如 "<prefix><序号>" 的行按到达顺序取出序号
+static std::vector<int> numbers(const FakeDevice &dev, const std::string &prefix) {
+  std::vector<int> out;
+  for (const auto &l : dev.lines())
+    if (l.compare(0, prefix.size(), prefix) == 0)
+      out.push_back(std::stoi(l.substr(prefix.size())));
+  return out;
+}
+
+// 0..n-1 每个都收到且整体不倒序（补发的未应答消息可能重复一次）
+static bool complete_in_order(const std::vector<int> &got, int n) {
+  std::set<int> seen(got.begin(), got.end());
+  for (std::size_t i = 1; i < got.size(); ++i)
+    if (got[i] < got[i - 1])
+      return false;
+  return static_cast<int>(seen.size()) == n && *seen.begin() == 0 && *seen.rbegin() == n - 1;
+}
+
+static uint16_t free_port() {
+  FakeDevice probe;
+  return probe.port();
+}
+
+static ConnInfo spill_info(uint16_t port, const std::string &dir) {
+  ConnInfo info;
+  info.ip = "127.0.0.1";
+  info.port = port;
+  info.write_mode = WriteMode::PIPELINED;
+  info.event_batch_delay = 0ms;
+  info.spill_dir = dir;
+  return info;
+}
+
+static std::shared_ptr<ClientManager> fast_retry_manager(boost::asio::io_context &io) {
+  auto mgr = std::make_shared<ClientManager>(io);
+  ReconnectPolicy policy;
+  policy.initial = 50ms;
+  policy.max = 100ms;
+  mgr->set_reconnect_policy(policy);
+  return mgr;
+}
+
+// 设备从未上线：消息与事件全部写入磁盘，设备上线后按序补发
+static void offline_then_online(boost::asio::io_context &io) {
+  std::printf("messages and events sent while offline are replayed in order\n");
+  uint16_t port = free_port();
+  auto mgr = fast_retry_manager(io);
+  ConnHandle h = mgr->add_connection(spill_info(port, "/tmp/testSpill-offline"));
+
+  const int total = 200;
+  std::size_t spilled = 0, events_spilled = 0;
+  for (int i = 0; i < total; ++i) {
+    if (i % 2 == 0) {
+      spilled += mgr->send_message(h, make_shared_message("n" + std::to_string(i) + "\n")) ==
+                 SendResult::SPILLED;
+    } else {
+      EventRouteResult r = mgr->on_redis_event(EventType::EVENT_A, "n" + std::to_string(i));
+      events_spilled += r.spilled == 1 && r.accepted == 1 && r.subscribers == 1;
+    }
+  }
+  check(spilled == total / 2, "messages to an offline endpoint spilled");
+  check(events_spilled == total / 2, "events for an offline endpoint spilled");
+
+  FakeDevice dev(true, 0ms, port);
+  check(wait_online(*mgr, h), "endpoint comes online");
+  check(wait_until([&] { return numbers(dev, "n").size() >= total; }, 5000ms),
+        "backlog replayed");
+  check(complete_in_order(numbers(dev, "n"), total), "replayed without gaps, in order");
+  EventRouteResult r = mgr->on_redis_event(EventType::EVENT_A, "live");
+  check(r.spilled == 0 && r.accepted == 1, "online endpoint receives events directly");
+  check(wait_until([&] { return dev.count("live") == 1; }), "live event delivered once");
+}
+
+// 设备掉线：已写出未获应答、尚未写出的消息和离线期间的事件都在重连后补发
+static void drop_and_reconnect(boost::asio::io_context &io) {
+  std::printf("unacknowledged and queued messages survive a drop\n");
+  uint16_t port = free_port();
+  auto mgr = fast_retry_manager(io);
+  ConnInfo info = spill_info(port, "/tmp/testSpill-drop");
+  ConnHandle h;
+  const int before = 20, total = 60;
+  {
+    FakeDevice silent(false, 0ms, port);  // 只收不回：写出的都停在未应答
+    h = mgr->add_connection(info);
+    check(wait_online(*mgr, h), "connected");
+    for (int i = 0; i < before; ++i)
+      mgr->send_message(h, make_shared_message("n" + std::to_string(i) + "\n"));
+    check(wait_until([&] { return silent.line_count() > 0; }), "some messages written");
+    mgr->start_send_loop();  // 空闲连接不读，掉线由心跳写出时发现
+    silent.drop_all();
+    check(wait_until([&] {
+            WriteStats ws;
+            return !mgr->write_stats(h, ws);
+          }, 5000ms),
+          "drop detected");
+  }
+  for (int i = before; i < total; ++i)
+    mgr->on_redis_event(EventType::EVENT_A, "n" + std::to_string(i));
+
+  FakeDevice dev(true, 0ms, port);
+  check(wait_until([&] { return numbers(dev, "n").size() >= total; }, 5000ms),
+        "everything replayed after reconnect");
+  check(complete_in_order(numbers(dev, "n"), total), "no message lost, order kept");
+}
+
+// 在线但设备慢：高水位以上的消息写入磁盘，队列回落后取回，整体仍按发送顺序
+static void overflow_while_online(boost::asio::io_context &io) {
+  std::printf("messages above the high watermark are replayed in order\n");
+  FakeDevice dev(true, 1ms);
+  auto mgr = std::make_shared<ClientManager>(io);
+  ConnInfo info = spill_info(dev.port(), "/tmp/testSpill-overflow");
+  info.max_inflight = 4;
+  info.high_watermark = 16;
+  info.low_watermark = 4;
+  ConnHandle h = mgr->add_connection(info);
+  check(wait_online(*mgr, h), "connected");
+
+  const int total = 300;
+  std::size_t spilled = 0;
+  for (int i = 0; i < total; ++i)
+    spilled += mgr->send_message(h, make_shared_message("n" + std::to_string(i) + "\n")) ==
+               SendResult::SPILLED;
+  check(spilled > 0, "some messages spilled");
+  check(wait_until([&] { return numbers(dev, "n").size() >= total; }, 10000ms),
+        "everything written");
+  check(complete_in_order(numbers(dev, "n"), total), "spilled and queued interleave in order");
+  SpillStats ss;
+  mgr->spill_stats(h, ss);
+  check(ss.pending == 0 && ss.replayed == ss.spilled && ss.spilled == spilled,
+        "spill stats balance");
+}
+
+int main() {
+  std::setvbuf(stdout, nullptr, _IOLBF, 0);
+  std::system("rm -rf /tmp/testSpill-offline /tmp/testSpill-drop /tmp/testSpill-overflow");
+  IoRunner runner;
+  offline_then_online(runner.io());
+  drop_and_reconnect(runner.io());
+  overflow_while_online(runner.io());
+  return summary();
+}
@@ -0,0 +1,200 @@
+// 管理器析构测试：ClientManager 先于连接、时间轮和在途回调释放时不得访问已释放的对象，
+// 未完成的请求以 DISCONNECTED 恰好回调一次
+//
+// 编译: g++ -std=c++17 -g -O1 -fsanitize=address,undefined -I.. testTeardown.cpp -o testTeardown -lpthread
+// 运行: ./testTeardown    （全部通过时退出码为 0）
+//
+// 进程内服务端每收到一行，延迟 300ms 回一行，保证管理器析构时回复尚在路上。
+// 各场景在管理器析构后继续运行 io_context，让迟到的回复、超时、心跳与建连回调都落地。
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clientManager.h"
+
+using boost::asio::ip::tcp;
+using namespace std::chrono_literals;
+
+static int g_failed = 0;
+
+static void check(bool ok, const char *what) {
+  std::printf("  [%s] %s\n", ok ? "PASS" : "FAIL", what);
+  if (!ok)
+    ++g_failed;
+}
+
+// 每条连接一个线程：每收到一行，等待 delay 后回 "reply\n"
+class DelayedServer {
+public:
+  explicit DelayedServer(std::chrono::milliseconds delay)
+      : acceptor_(io_, tcp::endpoint(tcp::v4(), 0)), delay_(delay) {
+    accept_thread_ = std::thread([this] {
+      for (;;) {
+        auto s = std::make_shared<tcp::socket>(io_);
+        boost::system::error_code ec;
+        acceptor_.accept(*s, ec);
+        if (ec || stopping_)
+          return;
+        sessions_.emplace_back([this, s] { serve(*s); });
+      }
+    });
+  }
+
+  ~DelayedServer() {
+    // 关闭 acceptor 唤不醒阻塞的 accept，连一次让它返回
+    stopping_ = true;
+    boost::system::error_code ec;
+    tcp::socket poke(io_);
+    poke.connect(tcp::endpoint(boost::asio::ip::address_v4::loopback(), port()), ec);
+    accept_thread_.join();
+    acceptor_.close(ec);
+    for (auto &t : sessions_)
+      t.join();
+  }
+
+  uint16_t port() const { return port_; }
+
+private:
+  void serve(tcp::socket &s) {
+    char buf[4096];
+    boost::system::error_code ec;
+    for (;;) {
+      std::size_t n = s.read_some(boost::asio::buffer(buf), ec);
+      if (ec)
+        return;
+      std::size_t lines = 0;
+      for (std::size_t i = 0; i < n; ++i)
+        lines += buf[i] == '\n';
+      std::this_thread::sleep_for(delay_);
+      std::string reply;
+      for (std::size_t i = 0; i < lines; ++i)
+        reply += "reply\n";
+      boost::asio::write(s, boost::asio::buffer(reply), ec);
+      if (ec)
+        return;
+    }
+  }
+
+  boost::asio::io_context io_;
+  tcp::acceptor acceptor_;
+  uint16_t port_ = acceptor_.local_endpoint().port();
+  std::chrono::milliseconds delay_;
+  std::atomic<bool> stopping_{false};
+  std::thread accept_thread_;
+  std::vector<std::thread> sessions_;
+};
+
+struct Outcome {
+  std::atomic<int> calls{0};
+  std::atomic<int> status{-1};
+};
+
+static ReplyCallback record(const std::shared_ptr<Outcome> &o) {
+  return [o](RequestStatus st, std::string_view) {
+    o->calls.fetch_add(1);
+    o->status.store(static_cast<int>(st));
+  };
+}
+
+static bool wait_replies(ClientManager &mgr, ConnHandle h) {
+  for (int i = 0; i < 200; ++i) {
+    WriteStats ws;
+    if (mgr.write_stats(h, ws))
+      return true;
+    std::this_thread::sleep_for(10ms);
+  }
+  return false;
+}
+
+// 在途请求的回复晚于管理器析构到达（复现回复路径访问已释放时间轮的问题）
+static void late_reply(boost::asio::io_context &io, bool per_core) {
+  std::printf("late reply after teardown%s\n", per_core ? " (per-core)" : "");
+  DelayedServer server(300ms);
+  std::unique_ptr<IoContextPool> pool;
+  std::shared_ptr<ClientManager> mgr;
+  if (per_core) {
+    pool.reset(new IoContextPool(2));
+    pool->run(false);
+    mgr = std::make_shared<ClientManager>(*pool);
+  } else {
+    mgr = std::make_shared<ClientManager>(io);
+  }
+  mgr->start_send_loop();
+  ConnInfo info;
+  info.ip = "127.0.0.1";
+  info.port = server.port();
+  info.write_mode = WriteMode::PIPELINED;
+  ConnHandle h = mgr->add_connection(info);
+  check(wait_replies(*mgr, h), "connected");
+
+  auto written = std::make_shared<Outcome>();   // 已写出、回复未到
+  auto short_dl = std::make_shared<Outcome>();  // 截止时间短于回复延迟
+  RequestTicket t1 = mgr->request(h, make_shared_message(std::string("q1\n")), 2000ms,
+                                  record(written));
+  RequestTicket t2 = mgr->request(h, make_shared_message(std::string("q2\n")), 100ms,
+                                  record(short_dl));
+  check(t1.accepted() && t2.accepted(), "requests accepted");
+  std::this_thread::sleep_for(50ms);
+  // 析构前一刻入队，多半尚未写出
+  auto queued = std::make_shared<Outcome>();
+  RequestTicket t3 = mgr->request(h, make_shared_message(std::string("q3\n")), 2000ms,
+                                  record(queued));
+  check(t3.accepted(), "last request accepted");
+  mgr.reset();
+
+  // 回复（300ms）、短截止时间（100ms）与心跳（1s）都在析构之后
+  std::this_thread::sleep_for(1500ms);
+  for (auto *o : {written.get(), short_dl.get(), queued.get()}) {
+    check(o->calls.load() == 1, "callback ran exactly once");
+    check(o->status.load() == static_cast<int>(RequestStatus::DISCONNECTED),
+          "request ended DISCONNECTED");
+  }
+  if (pool) {
+    pool->stop();
+    pool->join();
+  }
+}
+
+// 建连尚未完成时析构：完成回调发现管理器已不在，自行关闭连接
+static void teardown_while_connecting(boost::asio::io_context &io) {
+  std::printf("teardown while connecting\n");
+  auto mgr = std::make_shared<ClientManager>(io);
+  ReconnectPolicy policy;
+  policy.initial = 10ms;
+  mgr->set_reconnect_policy(policy);
+  DelayedServer server(0ms);
+  ConnInfo up;
+  up.ip = "127.0.0.1";
+  up.port = server.port();
+  ConnInfo down = up;
+  down.port = 1;  // 拒绝连接，进入退避重连
+  mgr->add_connection(up);
+  mgr->add_connection(down);
+  mgr.reset();
+  std::this_thread::sleep_for(200ms);
+  check(true, "no access after teardown");
+}
+
+int main() {
+  std::setvbuf(stdout, nullptr, _IOLBF, 0);
+  boost::asio::io_context io;
+  auto guard = boost::asio::make_work_guard(io);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 2; ++i)
+    threads.emplace_back([&io] { io.run(); });
+
+  late_reply(io, false);
+  late_reply(io, true);
+  teardown_while_connecting(io);
+
+  guard.reset();
+  io.stop();
+  for (auto &t : threads)
+    t.join();
+  std::printf(g_failed ? "FAILED: %d\n" : "all passed\n", g_failed);
+  return g_failed ? 1 : 0;
+}
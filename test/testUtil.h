@@ -0,0 +1,206 @@
+#pragma once
+
+// 各测试程序共用的小工具：断言计数、条件等待与进程内的设备替身
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clientManager.h"
+
+namespace testutil {
+
+using boost::asio::ip::tcp;
+using namespace std::chrono_literals;
+
+inline int &failed() {
+  static int n = 0;
+  return n;
+}
+
+inline void check(bool ok, const char *what) {
+  std::printf("  [%s] %s\n", ok ? "PASS" : "FAIL", what);
+  if (!ok)
+    ++failed();
+}
+
+// 打印汇总并给出进程退出码
+inline int summary() {
+  std::printf(failed() ? "FAILED: %d\n" : "all passed\n", failed());
+  return failed() ? 1 : 0;
+}
+
+// 每 10ms 检查一次 pred，直到为真或超时
+inline bool wait_until(const std::function<bool()> &pred,
+                       std::chrono::milliseconds timeout = 2000ms) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!pred()) {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+    std::this_thread::sleep_for(10ms);
+  }
+  return true;
+}
+
+// 设备替身：每条连接一个线程，按行记录收到的内容。
+// reply 为真时每收到一行，等待 delay 后回 "reply\n"（行首为 "id=" 时原样回显该行，
+// 供按 id 对应的请求测试）；为假时只收不回，PING_PONG 连接因此停在第一条上。
+// port 为 0 时由系统分配；指定端口可模拟设备下线后在原地址重新上线
+class FakeDevice {
+public:
+  explicit FakeDevice(bool reply = true, std::chrono::milliseconds delay = 0ms,
+                      uint16_t port = 0)
+      : acceptor_(io_, tcp::endpoint(tcp::v4(), port)), reply_(reply), delay_(delay) {
+    accept_thread_ = std::thread([this] {
+      for (;;) {
+        auto s = std::make_shared<tcp::socket>(io_);
+        boost::system::error_code ec;
+        acceptor_.accept(*s, ec);
+        if (ec || stopping_)
+          return;
+        std::lock_guard<std::mutex> lock(mtx_);
+        sockets_.push_back(s);
+        ++accepted_;
+        sessions_.emplace_back([this, s] { serve(*s); });
+      }
+    });
+  }
+
+  ~FakeDevice() {
+    // 关闭 acceptor 唤不醒阻塞的 accept，连一次让它返回
+    stopping_ = true;
+    boost::system::error_code ec;
+    tcp::socket poke(io_);
+    poke.connect(tcp::endpoint(boost::asio::ip::address_v4::loopback(), port()), ec);
+    accept_thread_.join();
+    acceptor_.close(ec);
+    drop_all();
+    for (auto &t : sessions_)
+      t.join();
+  }
+
+  uint16_t port() const { return port_; }
+
+  // 断开当前所有连接（模拟设备掉线），之后仍接受新连接
+  void drop_all() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto &s : sockets_) {
+      boost::system::error_code ec;
+      s->shutdown(tcp::socket::shutdown_both, ec);
+    }
+  }
+
+  std::vector<std::string> lines() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return lines_;
+  }
+
+  std::size_t line_count() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return lines_.size();
+  }
+
+  // 内容等于 line 的行数
+  std::size_t count(const std::string &line) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::size_t n = 0;
+    for (const auto &l : lines_)
+      n += l == line;
+    return n;
+  }
+
+  int accepted() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return accepted_;
+  }
+
+private:
+  void serve(tcp::socket &s) {
+    char buf[4096];
+    std::string partial;
+    boost::system::error_code ec;
+    for (;;) {
+      std::size_t n = s.read_some(boost::asio::buffer(buf), ec);
+      if (ec)
+        return;
+      std::string reply;
+      partial.append(buf, n);
+      std::size_t start = 0, nl;
+      while ((nl = partial.find('\n', start)) != std::string::npos) {
+        std::string line = partial.substr(start, nl - start);
+        start = nl + 1;
+        if (line.compare(0, 3, "id=") == 0)
+          reply += line + "\n";
+        else
+          reply += "reply\n";
+        std::lock_guard<std::mutex> lock(mtx_);
+        lines_.push_back(std::move(line));
+      }
+      partial.erase(0, start);
+      if (!reply_ || reply.empty())
+        continue;
+      std::this_thread::sleep_for(delay_);
+      boost::asio::write(s, boost::asio::buffer(reply), ec);
+      if (ec)
+        return;
+    }
+  }
+
+  boost::asio::io_context io_;
+  tcp::acceptor acceptor_;
+  uint16_t port_ = acceptor_.local_endpoint().port();
+  bool reply_;
+  std::chrono::milliseconds delay_;
+  std::atomic<bool> stopping_{false};
+  std::thread accept_thread_;
+  mutable std::mutex mtx_;
+  std::vector<std::shared_ptr<tcp::socket>> sockets_;
+  std::vector<std::string> lines_;
+  int accepted_ = 0;
+  std::vector<std::thread> sessions_;
+};
+
+// 后台运行一个 io_context 的若干线程，析构时停止
+class IoRunner {
+public:
+  explicit IoRunner(int threads = 2) : guard_(boost::asio::make_work_guard(io_)) {
+    for (int i = 0; i < threads; ++i)
+      threads_.emplace_back([this] { io_.run(); });
+  }
+
+  ~IoRunner() {
+    guard_.reset();
+    io_.stop();
+    for (auto &t : threads_)
+      t.join();
+  }
+
+  boost::asio::io_context &io() { return io_; }
+
+private:
+  boost::asio::io_context io_;
+  boost::asio::executor_work_guard<boost::asio::io_context::executor_type> guard_;
+  std::vector<std::thread> threads_;
+};
+
+inline ConnInfo device_info(const FakeDevice &dev) {
+  ConnInfo info;
+  info.ip = "127.0.0.1";
+  info.port = dev.port();
+  return info;
+}
+
+// 等到端点在线（write_stats 只对在线连接返回 true）
+inline bool wait_online(ClientManager &mgr, ConnHandle h) {
+  return wait_until([&] {
+    WriteStats ws;
+    return mgr.write_stats(h, ws);
+  });
+}
+
+}  // namespace testutil
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// ============ TimingWheel =============
+// 分层时间轮：4 层 × 256 槽，默认 1ms 一格，第 0 层覆盖 256ms，
+// 逐层 ×256，最远约 49 天。定时器节点放在复用的 slab 里，以槽内双向链表串起：
+//   - schedule / cancel 均为 O(1)，不分配 asio 定时器、不进 asio 的定时器堆；
+//   - 高层槽在低层转满一圈时整体下沉（cascade），每个节点最多下沉 3 次；
+//   - 驱动只用一个 steady_timer，只在最近的非空槽或下一次下沉时醒来，
+//     空闲时不空转。
+// 可在任意线程调用 schedule / cancel（内部一把短锁）；回调在时间轮的
+// strand 上执行，需要访问连接状态的回调应自行 post 到连接的 strand。
+// cancel 与到期竞争时回调仍可能执行一次，回调需容忍这种迟到。
+// 只能由 create() 创建：各使用者（管理器与每条连接）各持一份 shared_ptr，
+// 时间轮活到最后一个使用者释放；内部投递的驱动回调只持弱引用，不延长寿命。
+// 回调本身捕获的对象仍需自行保活（shared_ptr）或判活（weak_ptr）。
+class TimingWheel : public std::enable_shared_from_this<TimingWheel> {
+public:
+  using Ptr = std::shared_ptr<TimingWheel>;
+  using Clock = std::chrono::steady_clock;
+  using Callback = std::function<void()>;
+  using TimerId = uint64_t;  // 0 表示无效
+
+  static Ptr create(boost::asio::io_context &io,
+                    std::chrono::milliseconds tick = std::chrono::milliseconds(1)) {
+    return Ptr(new TimingWheel(io, tick));
+  }
+
+  TimingWheel(const TimingWheel &) = delete;
+  TimingWheel &operator=(const TimingWheel &) = delete;
+
+  // after 之后（不早于）执行 cb，精度为一格
+  TimerId schedule(Clock::duration after, Callback cb) {
+    bool rearm = false;
+    TimerId id;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto due = std::max(Clock::now() - start_ + after, Clock::duration::zero());
+      uint64_t deadline = static_cast<uint64_t>((due + tick_ - Clock::duration(1)) / tick_);
+      uint32_t idx = alloc();
+      Node &n = nodes_[idx];
+      n.cb = std::move(cb);
+      n.deadline = deadline;
+      link(idx);
+      ++size_;
+      id = (static_cast<uint64_t>(n.gen) << 32) | (idx + 1);
+      if (deadline < wake_tick_) {
+        wake_tick_ = deadline;
+        rearm = true;
+      }
+    }
+    if (rearm)
+      boost::asio::post(strand_, [w = weak_from_this()] {
+        if (auto self = w.lock())
+          self->arm();
+      });
+    return id;
+  }
+
+  // 已到期或已取消时返回 false
+  bool cancel(TimerId id) {
+    Callback dead;  // 在锁外析构，回调捕获的对象析构时可能再进入时间轮
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      uint32_t idx = static_cast<uint32_t>(id & 0xffffffffu) - 1;
+      if (id == 0 || idx >= nodes_.size())
+        return false;
+      Node &n = nodes_[idx];
+      if (!n.active || n.gen != static_cast<uint32_t>(id >> 32))
+        return false;
+      unlink(idx);
+      dead = std::move(n.cb);
+      release(idx);
+      --size_;
+    }
+    return true;
+  }
+
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return size_;
+  }
+
+  std::chrono::milliseconds tick() const { return tick_; }
+
+private:
+  TimingWheel(boost::asio::io_context &io, std::chrono::milliseconds tick)
+      : strand_(boost::asio::make_strand(io)), timer_(io),
+        tick_(tick.count() > 0 ? tick : std::chrono::milliseconds(1)),
+        start_(Clock::now()) {
+    for (auto &level : heads_)
+      level.fill(kNil);
+  }
+
+  static constexpr unsigned kBits = 8;
+  static constexpr std::size_t kSlots = std::size_t(1) << kBits;
+  static constexpr uint64_t kMask = kSlots - 1;
+  static constexpr unsigned kLevels = 4;
+  static constexpr uint32_t kNil = std::numeric_limits<uint32_t>::max();
+  static constexpr uint64_t kNever = std::numeric_limits<uint64_t>::max();
+
+  struct Node {
+    Callback cb;
+    uint64_t deadline = 0;  // 绝对格号
+    uint32_t gen = 0;       // 复用计数，防止旧 TimerId 误取消新定时器
+    uint32_t prev = kNil;
+    uint32_t next = kNil;   // 空闲时串成空闲链表
+    uint16_t bucket = 0;    // level * kSlots + slot
+    bool active = false;
+  };
+
+  uint32_t alloc() {
+    uint32_t idx;
+    if (free_ != kNil) {
+      idx = free_;
+      free_ = nodes_[idx].next;
+    } else {
+      idx = static_cast<uint32_t>(nodes_.size());
+      nodes_.emplace_back();
+    }
+    nodes_[idx].active = true;
+    return idx;
+  }
+
+  void release(uint32_t idx) {
+    Node &n = nodes_[idx];
+    n.active = false;
+    ++n.gen;
+    n.prev = kNil;
+    n.next = free_;
+    free_ = idx;
+  }
+
+  // 按与当前格的距离选层；已过期的放进当前格，下一次推进即触发
+  void link(uint32_t idx) {
+    Node &n = nodes_[idx];
+    uint64_t d = std::max(n.deadline, cur_);
+    uint64_t delta = d - cur_;
+    unsigned level = 0;
+    while (level + 1 < kLevels && delta >= (uint64_t(1) << (kBits * (level + 1))))
+      ++level;
+    if (level + 1 == kLevels && delta >= (uint64_t(1) << (kBits * kLevels))) {
+      d = cur_ + (uint64_t(1) << (kBits * kLevels)) - 1;
+      n.deadline = d;
+    }
+    std::size_t slot = static_cast<std::size_t>((d >> (kBits * level)) & kMask);
+    n.bucket = static_cast<uint16_t>(level * kSlots + slot);
+    uint32_t &head = heads_[level][slot];
+    n.prev = kNil;
+    n.next = head;
+    if (head != kNil)
+      nodes_[head].prev = idx;
+    head = idx;
+    ++counts_[level];
+  }
+
+  void unlink(uint32_t idx) {
+    Node &n = nodes_[idx];
+    unsigned level = n.bucket / kSlots;
+    uint32_t &head = heads_[level][n.bucket % kSlots];
+    if (n.prev != kNil)
+      nodes_[n.prev].next = n.next;
+    else
+      head = n.next;
+    if (n.next != kNil)
+      nodes_[n.next].prev = n.prev;
+    --counts_[level];
+  }
+
+  // 低层转满一圈时，把高层对应槽的节点重新按距离放置
+  void cascade(uint64_t t) {
+    for (unsigned level = kLevels - 1; level >= 1; --level) {
+      if ((t & ((uint64_t(1) << (kBits * level)) - 1)) != 0)
+        continue;
+      uint32_t &head = heads_[level][(t >> (kBits * level)) & kMask];
+      uint32_t idx = head;
+      head = kNil;
+      while (idx != kNil) {
+        uint32_t next = nodes_[idx].next;
+        --counts_[level];
+        link(idx);
+        idx = next;
+      }
+    }
+  }
+
+  // 处理 (cur_, target] 之间的所有格；第 0 层为空时直接跳到下一圈起点
+  void advance(uint64_t target) {
+    while (cur_ <= target) {
+      if ((cur_ & kMask) == 0)
+        cascade(cur_);
+      if (counts_[0] == 0) {
+        cur_ = std::min((cur_ | kMask) + 1, target + 1);
+        continue;
+      }
+      uint32_t &head = heads_[0][cur_ & kMask];
+      uint32_t idx = head;
+      head = kNil;
+      while (idx != kNil) {
+        Node &n = nodes_[idx];
+        uint32_t next = n.next;
+        due_.push_back(std::move(n.cb));
+        --counts_[0];
+        --size_;
+        release(idx);
+        idx = next;
+      }
+      ++cur_;
+    }
+  }
+
+  uint64_t next_wake() const {
+    if (size_ == 0)
+      return kNever;
+    uint64_t wake = kNever;
+    if (counts_[0] != 0) {
+      for (uint64_t t = cur_; t < cur_ + kSlots; ++t) {
+        if (heads_[0][t & kMask] != kNil) {
+          wake = t;
+          break;
+        }
+      }
+    }
+    // cur_ 恰在一圈起点时，它的下沉尚未做
+    if (size_ > counts_[0])
+      wake = std::min(wake, (cur_ & kMask) == 0 ? cur_ : (cur_ | kMask) + 1);
+    return wake;
+  }
+
+  // 仅在 strand 上调用
+  void arm() {
+    uint64_t wake;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      wake = next_wake();
+      wake_tick_ = wake;
+    }
+    if (wake == kNever)
+      return;
+    timer_.expires_at(start_ + tick_ * wake);
+    // 到期与析构竞争时完成回调可能已带着成功状态排队，只凭错误码不能判活；
+    // 回调执行期间 self 保活，管理器在回调里析构也不会连带释放时间轮
+    timer_.async_wait(boost::asio::bind_executor(
+        strand_, [w = weak_from_this()](boost::system::error_code ec) {
+          if (ec == boost::asio::error::operation_aborted)
+            return;  // 被更早的重新布置取代
+          if (auto self = w.lock())
+            self->on_timer();
+        }));
+  }
+
+  void on_timer() {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      advance(static_cast<uint64_t>((Clock::now() - start_) / tick_));
+    }
+    for (auto &cb : due_)
+      cb();
+    due_.clear();
+    arm();
+  }
+
+  boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+  boost::asio::steady_timer timer_;
+  std::chrono::milliseconds tick_;
+  Clock::time_point start_;
+  mutable std::mutex mtx_;
+  std::vector<Node> nodes_;
+  uint32_t free_ = kNil;
+  std::array<std::array<uint32_t, kSlots>, kLevels> heads_;
+  std::array<std::size_t, kLevels> counts_{};
+  std::size_t size_ = 0;
+  uint64_t cur_ = 0;             // 下一个待处理的格
+  uint64_t wake_tick_ = kNever;  // 驱动定时器当前的唤醒格
+  std::vector<Callback> due_;    // 本次到期的回调，仅在 strand 上使用
+};